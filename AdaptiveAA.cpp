@@ -0,0 +1,190 @@
+#include "AdaptiveAA.h"
+#include "Mat4.h"
+
+#include <stdio.h>
+
+AdaptiveAA::AdaptiveAA()
+	: edgeShader(NULL), edgeQueryIssued(false), width(0), height(0) {}
+
+AdaptiveAA::~AdaptiveAA()
+{
+	release();
+}
+
+bool AdaptiveAA::init(ShaderCache &cache)
+{
+	if (!(edgeShader = cache.get("basic.vert", "edge.frag")))
+	{
+		printf("Failed to link edge shader!\n");
+		return false;
+	}
+
+	if (edgeShader->getUniformLocation("u_ModelViewProjectionMatrix") == -1 ||
+		edgeShader->getUniformLocation("u_NormalDepth") == -1)
+	{
+		printf("Failed to locate edge shader uniforms!\n");
+		return false;
+	}
+
+	return edgeQuery.create();
+}
+
+void AdaptiveAA::release()
+{
+	releaseTarget();
+
+	edgeQuery.reset();
+	edgeQueryIssued = false;
+}
+
+void AdaptiveAA::releaseTarget()
+{
+	fbo.reset();
+	colorTexture.reset();
+	normalDepthTexture.reset();
+	depthStencil.reset();
+}
+
+// (re)create the offscreen target when the framebuffer size changes
+void AdaptiveAA::resize(int width, int height)
+{
+	if (fbo.get() && width == this->width && height == this->height)
+		return;
+
+	releaseTarget();
+	this->width = width;
+	this->height = height;
+
+	colorTexture.create();
+	glBindTexture(GL_TEXTURE_2D, colorTexture.get());
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+	colorTexture.setBytes(textureBytes(GL_RGBA8, width, height));
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+	normalDepthTexture.create();
+	glBindTexture(GL_TEXTURE_2D, normalDepthTexture.get());
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, width, height, 0, GL_RGBA, GL_FLOAT, NULL);
+	normalDepthTexture.setBytes(textureBytes(GL_RGBA16F, width, height));
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	depthStencil.create();
+	glBindRenderbuffer(GL_RENDERBUFFER, depthStencil.get());
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+	depthStencil.setBytes(textureBytes(GL_DEPTH24_STENCIL8, width, height));
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	fbo.create();
+	glBindFramebuffer(GL_FRAMEBUFFER, fbo.get());
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorTexture.get(), 0);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, normalDepthTexture.get(), 0);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depthStencil.get());
+
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		printf("Adaptive AA framebuffer is incomplete!\n");
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void AdaptiveAA::beginScene()
+{
+	static const GLenum buffers[] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+
+	glBindFramebuffer(GL_FRAMEBUFFER, fbo.get());
+	glDrawBuffers(2, buffers);
+	glViewport(0, 0, width, height);
+
+	glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+	glClearStencil(0);
+	glClear(GL_COLOR_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+}
+
+void AdaptiveAA::markEdges()
+{
+	// stencil only, the edge shader discards everything that isn't an edge
+	glDrawBuffer(GL_NONE);
+	glEnable(GL_STENCIL_TEST);
+	glStencilFunc(GL_ALWAYS, 1, 0xFF);
+	glStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);
+
+	edgeShader->bind();
+	edgeShader->setUniformMatrix4fv("u_ModelViewProjectionMatrix", 1, GL_FALSE, QUAD_PROJECTION.m);
+	edgeShader->setUniform1i("u_NormalDepth", 0);
+
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, normalDepthTexture.get());
+
+	glBeginQuery(GL_SAMPLES_PASSED, edgeQuery.get());
+	edgeQueryIssued = true;
+}
+
+void AdaptiveAA::beginRefine(int samples)
+{
+	glEndQuery(GL_SAMPLES_PASSED);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	// marked pixels only, the refine pass outputs the sum of the other samples
+	// over the sample count so weighting the centre by 1/samples averages them
+	glDrawBuffer(GL_COLOR_ATTACHMENT0);
+	glStencilFunc(GL_EQUAL, 1, 0xFF);
+	glStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
+
+	glEnable(GL_BLEND);
+	glBlendColor(0.0f, 0.0f, 0.0f, 1.0f / samples);
+	glBlendFunc(GL_ONE, GL_CONSTANT_ALPHA);
+}
+
+void AdaptiveAA::present()
+{
+	glDisable(GL_BLEND);
+	glDisable(GL_STENCIL_TEST);
+
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo.get());
+	glReadBuffer(GL_COLOR_ATTACHMENT0);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+	glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void AdaptiveAA::bindColor()
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, fbo.get());
+	glDrawBuffer(GL_COLOR_ATTACHMENT0);
+	glViewport(0, 0, width, height);
+
+	glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+	glClear(GL_COLOR_BUFFER_BIT);
+}
+
+void AdaptiveAA::readColor(unsigned char *rgba) const
+{
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo.get());
+	glReadBuffer(GL_COLOR_ATTACHMENT0);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, rgba);
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+}
+
+bool AdaptiveAA::getEdgePixels(GLuint &count, bool wait) const
+{
+	if (!edgeQueryIssued)
+		return false;
+
+	if (!wait)
+	{
+		GLint available = 0;
+		glGetQueryObjectiv(edgeQuery.get(), GL_QUERY_RESULT_AVAILABLE, &available);
+		if (!available)
+			return false;
+	}
+
+	glGetQueryObjectuiv(edgeQuery.get(), GL_QUERY_RESULT, &count);
+	return true;
+}
+
+int AdaptiveAA::getWidth() const { return width; }
+
+int AdaptiveAA::getHeight() const { return height; }
@@ -0,0 +1,59 @@
+#ifndef ADAPTIVEAA_H
+#define ADAPTIVEAA_H
+
+#include <GL/glew.h>
+#include "GLResource.h"
+#include "Shader.h"
+#include "ShaderCache.h"
+
+// edge-adaptive supersampling. the scene is traced once per pixel into an
+// offscreen target along with normals and depth, discontinuities are marked
+// in the stencil buffer and only those pixels are traced again with jittered
+// samples. the caller draws the quad between the passes:
+//
+//	beginScene()	-> scene with one sample and the gbuffer output
+//	markEdges()		-> fullscreen quad, edge shader already bound
+//	beginRefine()	-> scene with AA_SAMPLES samples and REFINE defined, which
+//					   skips the centre sample and gets it blended in instead
+//	present()
+class AdaptiveAA
+{
+public:
+	AdaptiveAA();
+	~AdaptiveAA();
+
+	bool init(ShaderCache &cache);
+	void release();
+	void resize(int width, int height);
+
+	void beginScene();
+	void markEdges();
+	void beginRefine(int samples);
+	void present();
+
+	// plain offscreen colour target, used for the reference images
+	void bindColor();
+	void readColor(unsigned char *rgba) const;
+
+	// pixels marked in the last markEdges, blocks if wait is set
+	bool getEdgePixels(GLuint &count, bool wait = false) const;
+
+	int getWidth() const;
+	int getHeight() const;
+
+private:
+	AdaptiveAA(const AdaptiveAA &);
+	AdaptiveAA &operator = (const AdaptiveAA &);
+
+	void releaseTarget();
+
+	Shader *edgeShader;
+	GLFramebuffer fbo;
+	GLTexture colorTexture, normalDepthTexture;
+	GLRenderbuffer depthStencil;
+	GLQuery edgeQuery;
+	bool edgeQueryIssued;
+	int width, height;
+};
+
+#endif
@@ -1,5 +1,12 @@
 #include "Application.h"
+#include "CpuRenderer.h"
 #include "Mat4.h"
+#include "TextureFile.h"
+
+#include <algorithm>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
 
 void Application::error_callback(int error, const char* description)
 {
@@ -13,27 +20,285 @@ void Application::key_callback(GLFWwindow* window, int key, int scancode, int ac
 		glfwSetWindowShouldClose(window, GL_TRUE);
 }
 
+Application::Application()
+	: window(NULL), aaMode(AA_OFF), aaSamples(4), aaReport(false),
+	progressiveWidth(0), progressiveHeight(0), progressiveSamples(64), progressiveNoise(0.0f),
+	progressiveOutput("still.ppm"), useCompute(false), computeBench(false),
+	workerGL(false), workerFailAfter(0), tileWidth(0), tileHeight(0),
+	jobThreads(0), jobBench(false), cpuPreview(false), vertexBench(false), mathBench(false),
+	contextCount(0), contextOffscreen(false), contextFrames(0), contextWidth(INIT_WIDTH), contextHeight(INIT_HEIGHT),
+	contextScaling(false), glStats(false), background(NULL)
+{
+	// built first so it outlives every handle released in the destructor
+	GLResourceRegistry::getInstance();
+}
+
 // destroy opengl buffers
 Application::~Application()
 {
-	glDeleteBuffers(1, &VBO);
-	glDeleteBuffers(1, &uvBuffer);
-	glDeleteBuffers(1, &IBO);
-	glDeleteVertexArrays(1, &vertexArray);
+	// the farm coordinator and cpu workers never create a context
+	if (window)
+	{
+		GLResourceRegistry &resources = GLResourceRegistry::getInstance();
+		if (glStats)
+			resources.report();
+
+		aa.release();
+		progressive.release();
+		compute.release();
+		shaders.clear();
+
+		tileFramebuffer.reset();
+		tileTexture.reset();
+
+		quad.release();
+		frameTimer.release();
+		streamer.release();
+
+		resources.checkLeaks();
+
+		glfwDestroyWindow(window);
+	}
 
-	glfwDestroyWindow(window);
 	glfwTerminate();
 }
 
 bool Application::initialize(int argc, char *argv[])
 {
-	if (!(initGLFW() && initGLEW() && initShader() && initContent()))
+	farm.executable = Process::executablePath(argv[0]);
+
+	if (!parseArgs(argc, argv))
+		return false;
+
+	// a thread per core only where jobs get submitted, every farm worker
+	// process would start its own pool otherwise
+	const bool usesJobs = cpuPreview || jobBench || !texturePath.empty();
+	JobSystem::getInstance().init(usesJobs ? jobThreads : 1);
+
+	if ((farm.workers > 0 || !workerAddress.empty()) && !Socket::startup())
+	{
+		printf("Failed to initialize sockets!\n");
+		return false;
+	}
+
+	if (usesGL() && !(initGLFW() && initGLEW() && initShader() && initContent()))
 		return false;
 
 	printf("Initialization successful.\n");
 	return true;
 }
 
+// command line options
+bool Application::parseArgs(int argc, char *argv[])
+{
+	for (int i = 1; i < argc; ++i)
+	{
+		if (strcmp(argv[i], "--quality") == 0 && i + 1 < argc)
+		{
+			const int index = QualityGovernor::findTier(argv[++i]);
+			if (index < 0)
+			{
+				printf("Unknown quality tier %s!\n", argv[i]);
+				return false;
+			}
+
+			governor.pin(index);
+		}
+		else if (strcmp(argv[i], "--budget") == 0 && i + 1 < argc)
+		{
+			governor.setBudget((float)atof(argv[++i]));
+		}
+		else if (strcmp(argv[i], "--aa") == 0 && i + 1 < argc)
+		{
+			++i;
+			if (strcmp(argv[i], "off") == 0)
+				aaMode = AA_OFF;
+			else if (strcmp(argv[i], "adaptive") == 0)
+				aaMode = AA_ADAPTIVE;
+			else if (strcmp(argv[i], "supersample") == 0)
+				aaMode = AA_SUPERSAMPLE;
+			else
+			{
+				printf("Unknown AA mode %s!\n", argv[i]);
+				return false;
+			}
+		}
+		else if (strcmp(argv[i], "--aa-samples") == 0 && i + 1 < argc)
+		{
+			aaSamples = atoi(argv[++i]);
+			if (aaSamples < 2)
+			{
+				printf("AA needs at least 2 samples!\n");
+				return false;
+			}
+		}
+		else if (strcmp(argv[i], "--aa-report") == 0)
+		{
+			aaReport = true;
+		}
+		else if (strcmp(argv[i], "--progressive") == 0 && i + 1 < argc)
+		{
+			if (sscanf(argv[++i], "%dx%d", &progressiveWidth, &progressiveHeight) != 2)
+			{
+				printf("Expected WIDTHxHEIGHT after --progressive!\n");
+				return false;
+			}
+		}
+		else if (strcmp(argv[i], "--samples") == 0 && i + 1 < argc)
+		{
+			progressiveSamples = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--noise") == 0 && i + 1 < argc)
+		{
+			progressiveNoise = (float)atof(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--frame-budget") == 0 && i + 1 < argc)
+		{
+			progressive.setFrameBudget((float)atof(argv[++i]));
+		}
+		else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc)
+		{
+			progressiveOutput = argv[++i];
+		}
+		else if (strcmp(argv[i], "--compute") == 0)
+		{
+			useCompute = true;
+		}
+		else if (strcmp(argv[i], "--bench-compute") == 0)
+		{
+			computeBench = true;
+		}
+		else if (strcmp(argv[i], "--jobs") == 0 && i + 1 < argc)
+		{
+			jobThreads = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--bench-jobs") == 0)
+		{
+			jobBench = true;
+		}
+		else if (strcmp(argv[i], "--cpu") == 0)
+		{
+			cpuPreview = true;
+		}
+		else if (strcmp(argv[i], "--bench-vertex") == 0)
+		{
+			vertexBench = true;
+		}
+		else if (strcmp(argv[i], "--bench-math") == 0)
+		{
+			mathBench = true;
+		}
+		else if ((strcmp(argv[i], "--windows") == 0 || strcmp(argv[i], "--offscreen") == 0) && i + 1 < argc)
+		{
+			contextOffscreen = strcmp(argv[i], "--offscreen") == 0;
+			contextCount = atoi(argv[++i]);
+			if (contextCount < 1)
+			{
+				printf("Expected at least 1 context after %s!\n", argv[i - 1]);
+				return false;
+			}
+		}
+		else if (strcmp(argv[i], "--context-frames") == 0 && i + 1 < argc)
+		{
+			contextFrames = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--context-size") == 0 && i + 1 < argc)
+		{
+			if (sscanf(argv[++i], "%dx%d", &contextWidth, &contextHeight) != 2)
+			{
+				printf("Expected WIDTHxHEIGHT after --context-size!\n");
+				return false;
+			}
+		}
+		else if (strcmp(argv[i], "--context-scaling") == 0)
+		{
+			contextScaling = true;
+		}
+		else if (strcmp(argv[i], "--gl-stats") == 0)
+		{
+			glStats = true;
+		}
+		else if (strcmp(argv[i], "--gl-budget") == 0 && i + 1 < argc)
+		{
+			GLResourceRegistry::getInstance().setBudget((size_t)(atof(argv[++i]) * 1048576.0));
+		}
+		else if (strcmp(argv[i], "--texture") == 0 && i + 1 < argc)
+		{
+			texturePath = argv[++i];
+			sceneDefines = "#define BACKGROUND_TEXTURE\n";
+		}
+		else if (strcmp(argv[i], "--texture-budget") == 0 && i + 1 < argc)
+		{
+			streamer.setBudget((size_t)(atof(argv[++i]) * 1024.0));
+		}
+		else if (strcmp(argv[i], "--make-texture") == 0 && i + 2 < argc)
+		{
+			textureSource = argv[++i];
+			textureOutput = argv[++i];
+		}
+		else if (strcmp(argv[i], "--farm") == 0 && i + 1 < argc)
+		{
+			farm.workers = atoi(argv[++i]);
+			if (farm.workers < 1)
+			{
+				printf("The render farm needs at least 1 worker!\n");
+				return false;
+			}
+		}
+		else if (strcmp(argv[i], "--farm-frames") == 0 && i + 1 < argc)
+		{
+			farm.frames = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--farm-size") == 0 && i + 1 < argc)
+		{
+			if (sscanf(argv[++i], "%dx%d", &farm.width, &farm.height) != 2)
+			{
+				printf("Expected WIDTHxHEIGHT after --farm-size!\n");
+				return false;
+			}
+		}
+		else if (strcmp(argv[i], "--farm-tile") == 0 && i + 1 < argc)
+		{
+			farm.tileSize = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--farm-output") == 0 && i + 1 < argc)
+		{
+			farm.output = argv[++i];
+		}
+		else if (strcmp(argv[i], "--farm-gl") == 0)
+		{
+			farm.useGL = true;
+		}
+		else if (strcmp(argv[i], "--farm-fault") == 0)
+		{
+			farm.fault = true;
+		}
+		else if (strcmp(argv[i], "--farm-scaling") == 0)
+		{
+			farm.scaling = true;
+		}
+		else if (strcmp(argv[i], "--worker") == 0 && i + 1 < argc)
+		{
+			workerAddress = argv[++i];
+		}
+		else if (strcmp(argv[i], "--worker-gl") == 0)
+		{
+			workerGL = true;
+		}
+		else if (strcmp(argv[i], "--fail-after") == 0 && i + 1 < argc)
+		{
+			workerFailAfter = atoi(argv[++i]);
+		}
+		else
+		{
+			printf("Unknown option %s!\n", argv[i]);
+			return false;
+		}
+	}
+
+	return true;
+}
+
 // for window creation and context handling
 bool Application::initGLFW()
 {
@@ -44,6 +309,19 @@ bool Application::initGLFW()
 		return false;
 	}
 
+	// compute shaders need 4.3, everything else runs on 3.3
+	if (useCompute || computeBench)
+	{
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+		glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+	}
+
+	// gl workers render offscreen, with several contexts the main one only
+	// holds what they share
+	if (!workerAddress.empty() || contextCount > 0)
+		glfwWindowHint(GLFW_VISIBLE, GL_FALSE);
+
 	if (!(window = glfwCreateWindow(INIT_WIDTH, INIT_HEIGHT, "Simple example", NULL, NULL)))
 	{
 		printf("Failed to create window!\n");
@@ -62,29 +340,97 @@ bool Application::initGLFW()
 // for extensions
 bool Application::initGLEW()
 {
+	// core profiles need this for glew to load anything
+	glewExperimental = GL_TRUE;
 	if (glewInit() != GLEW_OK)
 	{
 		printf("Failed to initialize glew!\n");
 		return false;
 	}
 
+	if ((useCompute || computeBench) && !ComputeRaymarcher::isSupported())
+	{
+		printf("Compute path needs OpenGL 4.3!\n");
+		return false;
+	}
+
 	printf("GLEW initialized.\n");
 	return true;
 }
 
-// shader setup
+// shader setup, every quality tier is compiled up front so switching never hitches
 bool Application::initShader()
 {
-	// link
-	if (!(shader.attachVertexShader("basic.vert") &&
-		shader.attachFragmentShader("basic.frag") &&
-		shader.link()))
+	char samples[64];
+	sprintf(samples, "#define AA_SAMPLES %d\n", aaSamples);
+
+	const bool needGBuffer = aaMode == AA_ADAPTIVE || aaReport;
+	const bool needSupersample = aaMode != AA_OFF || aaReport;
+
+	tierShaders.clear();
+
+	for (int i = 0; i < QualityGovernor::tierCount(); ++i)
 	{
-		printf("Failed to link shader!\n");
+		TierShaders tier;
+		tier.scene = initScene(i, "");
+		tier.gbuffer = needGBuffer ? initScene(i, "#define GBUFFER\n") : NULL;
+		tier.supersample = needSupersample ? initScene(i, samples) : NULL;
+		tier.refine = needGBuffer ? initScene(i, samples + std::string("#define REFINE\n")) : NULL;
+		tier.compute = useCompute || computeBench ? initCompute(i, "") : NULL;
+
+		// link
+		if (!tier.scene || (needGBuffer && !(tier.gbuffer && tier.refine)) || (needSupersample && !tier.supersample) ||
+			((useCompute || computeBench) && !tier.compute))
+		{
+			printf("Failed to link shader!\n");
+			return false;
+		}
+
+		tierShaders.push_back(tier);
+	}
+
+	if ((aaMode == AA_ADAPTIVE || aaReport) && !aa.init(shaders))
+		return false;
+
+	if (!frameTimer.init())
+	{
+		printf("Failed to create timer queries!\n");
 		return false;
 	}
 
-	// retrieve uniform locations
+	printf("Shader initialized.\n");
+	return true;
+}
+
+// one permutation of the scene for a quality tier
+Shader *Application::initScene(int tier, const std::string &defines)
+{
+	Shader *scene = shaders.get("basic.vert", "basic.frag", QualityGovernor::tier(tier).defines() + sceneDefines + defines);
+	if (!scene || !initUniforms(*scene))
+		return NULL;
+
+	return scene;
+}
+
+// one permutation of the compute raymarch for a quality tier
+Shader *Application::initCompute(int tier, const std::string &defines)
+{
+	Shader *compute = shaders.getCompute("raymarch.comp", QualityGovernor::tier(tier).defines() + defines);
+	if (!compute)
+		return NULL;
+
+	if (compute->getUniformLocation("u_Time") == -1 || compute->getUniformLocation("u_Resolution") == -1)
+	{
+		printf("Failed to locate compute uniforms!");
+		return NULL;
+	}
+
+	return compute;
+}
+
+// retrieve uniform locations
+bool Application::initUniforms(Shader &shader)
+{
 	if ((shader.getUniformLocation("u_ModelViewProjectionMatrix")) == -1)
 	{
 		printf("Failed to locate u_ModelViewProjectionMatrix!");
@@ -103,35 +449,30 @@ bool Application::initShader()
 		return false;
 	}
 
-	printf("Shader initialized.\n");
+	if (!texturePath.empty() && (shader.getUniformLocation("u_Background")) == -1)
+	{
+		printf("Failed to locate u_Background!");
+		return false;
+	}
+
 	return true;
 }
 
-// vbo setup
+// vbo setup, the quad spans 0-1 so normalized bytes hold it exactly
 bool Application::initContent()
 {
-	//vertices
-	if (!vertices.empty())
-		vertices.clear();
-
-	vertices.push_back(Vec3f(-1.0f, -1.0f, 0.0f));
-	vertices.push_back(Vec3f(1.0f, -1.0f, 0.0f));
-	vertices.push_back(Vec3f(1.0f, 1.0f, 0.0f));
-	vertices.push_back(Vec3f(-1.0f, 1.0f, 0.0f));
-	for (int i = 0, len = vertices.size(); i < len; ++i) // transform to 0-1
-		vertices[i] = vertices[i] * 0.5f + 0.5f;
-
-	// texture coordinates
-	if (!texCoords.empty())
-		texCoords.clear();
+	const float corners[][2] = { { 0.0f, 0.0f }, { 1.0f, 0.0f }, { 1.0f, 1.0f }, { 0.0f, 1.0f } };
 
-	for (int i = 0, len = vertices.size(); i < len; ++i)
-		texCoords.push_back(Vec2f(vertices[i].x, vertices[i].y));
+	std::vector<QuadLayout::Vertex> vertices(4);
+	for (int i = 0; i < 4; ++i)
+	{
+		const Vec2<unsigned char> corner(packNormalized<unsigned char>(corners[i][0]), packNormalized<unsigned char>(corners[i][1]));
+		attribute<0>(vertices[i]) = corner; // position
+		attribute<1>(vertices[i]) = corner; // texture coordinate
+	}
 
 	//indices
-	if (!indices.empty())
-		indices.clear();
-
+	std::vector<GLuint> indices;
 	indices.push_back(0);
 	indices.push_back(1);
 	indices.push_back(2);
@@ -139,65 +480,938 @@ bool Application::initContent()
 	indices.push_back(2);
 	indices.push_back(3);
 
-	glGenVertexArrays(1, &vertexArray);
-	glBindVertexArray(vertexArray);
+	if (!quad.upload<QuadLayout>(vertices, indices))
+		return false;
+
+	if (!texturePath.empty() && !(background = streamer.load(texturePath.c_str())))
+		return false;
+
+	printf("Buffers initialized.\n");
+	return true;
+}
 
-	//generate the buffers
-	glGenBuffers(1, &VBO);
-	glBindBuffer(GL_ARRAY_BUFFER, VBO);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(Vec3f) * vertices.size(), &vertices.front(), GL_STATIC_DRAW);
+// feed the frame timings to the governor and follow its tier
+void Application::updateQuality(double frameMs)
+{
+	double ms;
+	if (frameTimer.poll(ms))
+		gpuMs = ms;
 
-	glGenBuffers(1, &uvBuffer);
-	glBindBuffer(GL_ARRAY_BUFFER, uvBuffer);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(Vec2f) * texCoords.size(), &texCoords.front(), GL_STATIC_DRAW);
+	if (!governor.update((float)gpuMs, (float)frameMs))
+		return;
 
-	glGenBuffers(1, &IBO);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, IBO);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(GLuint) * indices.size(), &indices.front(), GL_STATIC_DRAW);
+	const QualityTier &tier = QualityGovernor::tier(governor.getTier());
+	printf("Quality tier: %s (%.2f ms frame, %.2f ms gpu, %.2f ms budget)\n",
+		tier.name, governor.getFrameAverage(), governor.getGpuAverage(), governor.getBudget());
+}
 
-	printf("Buffers initialized.\n");
+void Application::drawQuad()
+{
+	quad.draw();
+}
+
+void Application::drawScene(Shader &shader, int width, int height, float time)
+{
+	shader.bind();
+	shader.setUniformMatrix4fv("u_ModelViewProjectionMatrix", 1, GL_FALSE, QUAD_PROJECTION.m);
+	shader.setUniform1f("u_Time", time);
+	shader.setUniform2f("u_Resolution", width, height);
+
+	if (background)
+	{
+		glActiveTexture(GL_TEXTURE0 + BACKGROUND_TEXTURE_UNIT);
+		glBindTexture(GL_TEXTURE_2D, background->texture.get());
+		glActiveTexture(GL_TEXTURE0);
+		shader.setUniform1i("u_Background", BACKGROUND_TEXTURE_UNIT);
+	}
+
+	drawQuad();
+}
+
+// draws into whatever framebuffer is bound, adaptive AA ends with a blit to the window
+void Application::renderFrame(AAMode mode, int width, int height, float time)
+{
+	const TierShaders &tier = tierShaders[governor.getTier()];
+
+	if (mode == AA_ADAPTIVE)
+	{
+		aa.resize(width, height);
+		aa.beginScene();
+		drawScene(*tier.gbuffer, width, height, time);
+		aa.markEdges();
+		drawQuad();
+		aa.beginRefine(aaSamples);
+		drawScene(*tier.refine, width, height, time);
+		aa.present();
+		return;
+	}
+
+	// set viewport accordingly
+	glViewport(0, 0, width, height);
+
+	//clear it out
+	glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+	glClear(GL_COLOR_BUFFER_BIT);
+
+	drawScene(mode == AA_SUPERSAMPLE ? *tier.supersample : *tier.scene, width, height, time);
+}
+
+// peak signal to noise ratio of two rgba8 images, ignoring alpha
+static double computePSNR(const std::vector<unsigned char> &a, const std::vector<unsigned char> &b)
+{
+	double error = 0.0;
+	for (size_t i = 0; i < a.size(); ++i)
+	{
+		if (i % 4 == 3)
+			continue;
+
+		const double d = (double)a[i] - (double)b[i];
+		error += d * d;
+	}
+
+	const double mse = error / (a.size() / 4 * 3);
+	return mse > 0.0 ? 10.0 * log10(255.0 * 255.0 / mse) : 99.0;
+}
+
+// renders one frozen frame per AA mode offscreen and compares it against a
+// heavily supersampled reference, so quality can be weighed against cost
+void Application::reportAA()
+{
+	int width, height;
+	glfwGetFramebufferSize(window, &width, &height);
+
+	char samples[64];
+	sprintf(samples, "#define AA_SAMPLES %d\n", AA_REFERENCE_SAMPLES);
+
+	const float time = 1.0f;
+	Shader *reference = initScene(governor.getTier(), samples);
+	if (!reference)
+		return;
+
+	std::vector<unsigned char> truth(width * height * 4), image(width * height * 4);
+
+	aa.resize(width, height);
+	aa.bindColor();
+	drawScene(*reference, width, height, time);
+	aa.readColor(&truth[0]);
+
+	printf("AA report: %dx%d, %s tier, %d samples, %d sample reference\n",
+		width, height, QualityGovernor::tier(governor.getTier()).name, aaSamples, AA_REFERENCE_SAMPLES);
+	printf("%-12s %10s %10s %14s %10s\n", "mode", "ms", "PSNR dB", "dB/ms gained", "refined");
+
+	const char *names[] = { "1 spp", "adaptive", "supersample" };
+	double baseMs = 0.0, basePSNR = 0.0;
+
+	for (int mode = AA_OFF; mode <= AA_SUPERSAMPLE; ++mode)
+	{
+		glFinish();
+		const double start = glfwGetTime();
+
+		for (int frame = 0; frame < AA_REPORT_FRAMES; ++frame)
+		{
+			// everything but adaptive draws straight into the bound target
+			if (mode != AA_ADAPTIVE)
+				aa.bindColor();
+
+			renderFrame((AAMode)mode, width, height, time);
+		}
+
+		glFinish();
+		const double ms = (glfwGetTime() - start) * 1000.0 / AA_REPORT_FRAMES;
+
+		aa.readColor(&image[0]);
+		const double psnr = computePSNR(truth, image);
+
+		if (mode == AA_OFF)
+		{
+			baseMs = ms;
+			basePSNR = psnr;
+			printf("%-12s %10.2f %10.2f %14s %10s\n", names[mode], ms, psnr, "-", "-");
+			continue;
+		}
+
+		const double gain = ms > baseMs ? (psnr - basePSNR) / (ms - baseMs) : 0.0;
+
+		GLuint edges = width * height;
+		if (mode == AA_ADAPTIVE)
+			aa.getEdgePixels(edges, true);
+
+		printf("%-12s %10.2f %10.2f %14.3f %9.1f%%\n", names[mode], ms, psnr, gain, 100.0 * edges / (width * height));
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+// renders a still with time frozen, spread over as many frames as it takes,
+// then hands back to the interactive loop where the animation left off
+void Application::runProgressive()
+{
+	const double frozen = glfwGetTime();
+
+	// stills get the best tier unless one was asked for
+	Shader *scene = initScene(governor.isPinned() ? governor.getTier() : 0, "#define PROGRESSIVE\n");
+	if (!scene || !progressive.init(shaders, scene, progressiveWidth, progressiveHeight))
+		return;
+
+	progressive.setTarget(progressiveSamples, progressiveNoise);
+
+	while (!progressive.isDone() && !glfwWindowShouldClose(window))
+	{
+		progressive.beginFrame();
+		while (progressive.nextTile())
+			drawScene(*scene, progressive.getWidth(), progressive.getHeight(), (float)frozen);
+
+		if (progressive.endFrame())
+		{
+			progressive.beginNoise();
+			drawQuad();
+			progressive.endNoise();
+		}
+
+		int width, height;
+		glfwGetFramebufferSize(window, &width, &height);
+		progressive.beginPreview(width, height);
+		drawQuad();
+
+		glfwSwapBuffers(window);
+		glfwPollEvents();
+	}
+
+	progressive.report();
+	progressive.save(progressiveOutput.c_str());
+	progressive.release();
+
+	glfwSetTime(frozen);
+}
+
+// times the fragment path against the compute path, with and without the
+// tile skipping, at a few resolutions with time frozen
+void Application::benchCompute()
+{
+	static const int sizes[][2] = { { 320, 240 }, { 640, 480 }, { 1280, 720 }, { 1920, 1080 } };
+
+	const int tierIndex = governor.getTier();
+	Shader *fragment = tierShaders[tierIndex].scene;
+	Shader *skipping = tierShaders[tierIndex].compute;
+	Shader *plain = initCompute(tierIndex, "#define NO_TILE_SKIP\n");
+	if (!plain)
+		return;
+
+	const float time = 1.0f;
+
+	printf("Compute bench: %s tier, %d frames each\n", QualityGovernor::tier(tierIndex).name, COMPUTE_BENCH_FRAMES);
+	printf("%-12s %12s %12s %12s %10s %10s\n", "size", "fragment ms", "compute ms", "skipping ms", "speedup", "PSNR dB");
+
+	for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i)
+	{
+		const int width = sizes[i][0], height = sizes[i][1];
+		compute.resize(width, height);
+
+		std::vector<unsigned char> reference(width * height * 4), image(width * height * 4);
+
+		double ms[3];
+		for (int path = 0; path < 3; ++path)
+		{
+			// the first frame pays for shader compilation on some drivers
+			double start = 0.0;
+
+			for (int frame = -1; frame < COMPUTE_BENCH_FRAMES; ++frame)
+			{
+				if (frame == 0)
+				{
+					glFinish();
+					start = glfwGetTime();
+				}
+
+				if (path == 0)
+				{
+					compute.bindTarget();
+					drawScene(*fragment, width, height, time);
+				}
+				else
+					compute.dispatch(path == 1 ? *plain : *skipping, time);
+			}
+
+			glFinish();
+			ms[path] = (glfwGetTime() - start) * 1000.0 / COMPUTE_BENCH_FRAMES;
+
+			compute.readColor(path == 0 ? &reference[0] : &image[0]);
+		}
+
+		char size[32];
+		sprintf(size, "%dx%d", width, height);
+		printf("%-12s %12.2f %12.2f %12.2f %9.2fx %10.2f\n", size, ms[0], ms[1], ms[2], ms[0] / ms[2], computePSNR(reference, image));
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+// renders a frame with CpuRenderer, bands of rows spread over the job system
+void Application::renderCpu(std::vector<unsigned char> &rgb, int width, int height, int tier, float time)
+{
+	rgb.resize(width * height * 3);
+	unsigned char *pixels = &rgb[0];
+
+	JobSystem::getInstance().parallelFor(0, height, CPU_ROWS_PER_JOB, [=](int first, int last)
+	{
+		TileJob job;
+		job.id = 0;
+		job.frame = 0;
+		job.time = time;
+		job.tier = tier;
+		job.width = width;
+		job.height = height;
+		job.x = 0;
+		job.y = first;
+		job.w = width;
+		job.h = last - first;
+
+		CpuRenderer renderer;
+		renderer.renderTile(job, pixels + first * width * 3);
+	});
+}
+
+// upscales the cpu frame to the window
+void Application::presentCpu(int width, int height, int windowWidth, int windowHeight)
+{
+	if (!resizeTileTarget(width, height))
+		return;
+
+	glBindTexture(GL_TEXTURE_2D, tileTexture.get());
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, &cpuImage[0]);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, tileFramebuffer.get());
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+	glBlitFramebuffer(0, 0, width, height, 0, 0, windowWidth, windowHeight, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+// renders cpu frames and schedules empty jobs with a growing number of
+// threads, to show how the job system scales and what a job costs
+void Application::benchJobs()
+{
+	JobSystem &jobs = JobSystem::getInstance();
+
+	const int hardware = (int)std::thread::hardware_concurrency();
+	const int limit = jobThreads > 0 ? jobThreads : std::max(hardware, 4);
+	const int tier = governor.getTier();
+
+	printf("Job bench: %dx%d cpu frames, %s tier, %d frames each, %d hardware threads\n",
+		JOB_BENCH_WIDTH, JOB_BENCH_HEIGHT, QualityGovernor::tier(tier).name, JOB_BENCH_FRAMES, hardware);
+	printf("%-8s %10s %10s %11s %12s %8s %8s\n", "threads", "frame ms", "speedup", "efficiency", "utilization", "steals", "ns/job");
+
+	std::vector<unsigned char> rgb;
+	double baseMs = 0.0;
+
+	for (int count = 1; count <= limit; count *= 2)
+	{
+		jobs.init(count);
+
+		// the first frame faults the image in
+		renderCpu(rgb, JOB_BENCH_WIDTH, JOB_BENCH_HEIGHT, tier, 1.0f);
+
+		jobs.resetStats();
+		const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+		for (int frame = 0; frame < JOB_BENCH_FRAMES; ++frame)
+			renderCpu(rgb, JOB_BENCH_WIDTH, JOB_BENCH_HEIGHT, tier, 1.0f);
+
+		const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / JOB_BENCH_FRAMES;
+		const double utilization = jobs.getUtilization();
+		const unsigned int steals = jobs.getStealCount();
+
+		const std::chrono::steady_clock::time_point emptyStart = std::chrono::steady_clock::now();
+		jobs.parallelFor(0, JOB_BENCH_EMPTY, 1, [](int, int) {});
+		const double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - emptyStart).count() / JOB_BENCH_EMPTY;
+
+		if (count == 1)
+			baseMs = ms;
+
+		printf("%-8d %10.2f %9.2fx %10.1f%% %11.1f%% %8u %8.0f\n",
+			count, ms, baseMs / ms, 100.0 * baseMs / ms / count, 100.0 * utilization, steals, ns);
+	}
+
+	jobs.init(jobThreads);
+}
+
+// a rippled grid over [-1, 1] with size x size vertices
+static void makeGrid(int size, std::vector<Vec3f> &positions, std::vector<Vec3f> &normals,
+	std::vector<Vec2f> &texCoords, std::vector<GLuint> &indices)
+{
+	positions.clear();
+	normals.clear();
+	texCoords.clear();
+	indices.clear();
+
+	for (int y = 0; y < size; ++y)
+	{
+		for (int x = 0; x < size; ++x)
+		{
+			const float u = (float)x / (size - 1), v = (float)y / (size - 1);
+			const float px = u * 2.0f - 1.0f, py = v * 2.0f - 1.0f;
+
+			// height and its slopes
+			const float height = 0.1f * sinf(px * 8.0f) * cosf(py * 6.0f);
+			const float dx = 0.8f * cosf(px * 8.0f) * cosf(py * 6.0f);
+			const float dy = -0.6f * sinf(px * 8.0f) * sinf(py * 6.0f);
+
+			positions.push_back(Vec3f(px, py, height));
+			normals.push_back(Vec3f::normalize(Vec3f(-dx, -dy, 1.0f)));
+			texCoords.push_back(Vec2f(u, v));
+		}
+	}
+
+	for (int y = 0; y + 1 < size; ++y)
+	{
+		for (int x = 0; x + 1 < size; ++x)
+		{
+			const GLuint corner = y * size + x;
+			indices.push_back(corner);
+			indices.push_back(corner + 1);
+			indices.push_back(corner + size + 1);
+			indices.push_back(corner);
+			indices.push_back(corner + size + 1);
+			indices.push_back(corner + size);
+		}
+	}
+}
+
+// uploads generated grids as plain floats with 32 bit indices and as half
+// positions, byte normals and 16 bit texture coordinates with automatic index
+// width, then times drawing them with rasterization off so vertex fetch is
+// what gets measured
+void Application::benchVertex()
+{
+	static const int sizes[] = { 128, 256, 1024 };
+
+	Shader *shader = shaders.get("mesh.vert", "mesh.frag");
+	if (!shader)
+		return;
+
+	if (shader->getUniformLocation("u_ModelViewProjectionMatrix") == -1)
+	{
+		printf("Failed to locate u_ModelViewProjectionMatrix!\n");
+		return;
+	}
+
+	shader->bind();
+	shader->setUniformMatrix4fv("u_ModelViewProjectionMatrix", 1, GL_FALSE, Mat4f::identity().m);
+
+	printf("Vertex bench: %d draws per mesh, rasterizer discard\n", VERTEX_BENCH_DRAWS);
+	printf("%-10s %-8s %6s %6s %10s %10s %10s %7s %9s %9s %10s\n", "grid", "format", "stride", "index",
+		"vertex MB", "index MB", "total MB", "saved", "ms/draw", "Mtris/s", "max error");
+
+	std::vector<Vec3f> positions, normals;
+	std::vector<Vec2f> texCoords;
+	std::vector<GLuint> indices;
+
+	for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i)
+	{
+		makeGrid(sizes[i], positions, normals, texCoords, indices);
+
+		std::vector<FloatMeshLayout::Vertex> full(positions.size());
+		std::vector<CompactMeshLayout::Vertex> compact(positions.size());
+		float maxError = 0.0f;
+
+		for (size_t v = 0; v < positions.size(); ++v)
+		{
+			attribute<0>(full[v]) = positions[v];
+			attribute<1>(full[v]) = normals[v];
+			attribute<2>(full[v]) = texCoords[v];
+
+			const Vec3h position(positions[v].x, positions[v].y, positions[v].z);
+			attribute<0>(compact[v]) = position;
+			attribute<1>(compact[v]) = Vec3<signed char>(packNormalized<signed char>(normals[v].x),
+				packNormalized<signed char>(normals[v].y), packNormalized<signed char>(normals[v].z));
+			attribute<2>(compact[v]) = Vec2<unsigned short>(packNormalized<unsigned short>(texCoords[v].x),
+				packNormalized<unsigned short>(texCoords[v].y));
+
+			const Vec3f error = Vec3f(position.x, position.y, position.z) - positions[v];
+			maxError = std::max(maxError, std::max(fabsf(error.x), std::max(fabsf(error.y), fabsf(error.z))));
+		}
+
+		Mesh meshes[2];
+		meshes[0].upload<FloatMeshLayout>(full, indices, false);
+		meshes[1].upload<CompactMeshLayout>(compact, indices);
+
+		const char *names[] = { "float", "compact" };
+		const int strides[] = { FloatMeshLayout::stride, CompactMeshLayout::stride };
+		const double baseBytes = (double)(meshes[0].getVertexBytes() + meshes[0].getIndexBytes());
+
+		glEnable(GL_RASTERIZER_DISCARD);
+
+		for (int format = 0; format < 2; ++format)
+		{
+			const Mesh &mesh = meshes[format];
+
+			// the first draw pays for the upload on some drivers
+			mesh.draw();
+			glFinish();
+
+			const double start = glfwGetTime();
+			for (int draw = 0; draw < VERTEX_BENCH_DRAWS; ++draw)
+				mesh.draw();
+			glFinish();
+			const double ms = (glfwGetTime() - start) * 1000.0 / VERTEX_BENCH_DRAWS;
+
+			const double bytes = (double)(mesh.getVertexBytes() + mesh.getIndexBytes());
+
+			char grid[32], error[32];
+			sprintf(grid, "%dx%d", sizes[i], sizes[i]);
+			sprintf(error, format == 0 ? "-" : "%.6f", maxError);
+
+			printf("%-10s %-8s %6d %6d %10.2f %10.2f %10.2f %6.1f%% %9.3f %9.1f %10s\n", grid, names[format], strides[format],
+				(int)indexSize(mesh.getIndexType()) * 8, mesh.getVertexBytes() / 1048576.0, mesh.getIndexBytes() / 1048576.0,
+				bytes / 1048576.0, 100.0 * (1.0 - bytes / baseBytes), ms, mesh.getIndexCount() / 3 / ms / 1000.0, error);
+		}
+
+		glDisable(GL_RASTERIZER_DISCARD);
+
+		meshes[0].release();
+		meshes[1].release();
+	}
+
+	glBindVertexArray(0);
+}
+
+static float checksum(const Mat4f &mat)
+{
+	float sum = 0.0f;
+	for (int i = 0; i < 16; ++i)
+		sum += mat.m[i];
+
+	return sum;
+}
+
+// average ns per call of body over MATH_BENCH_ITERATIONS calls
+template <class Body>
+static double timeMath(Body body)
+{
+	const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for (int i = 0; i < MATH_BENCH_ITERATIONS; ++i)
+		body();
+
+	return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / MATH_BENCH_ITERATIONS;
+}
+
+// the quad projection used to be built every frame, this compares that with
+// the folded constant. the inputs are volatile so the runtime cases stay
+// runtime, and every case pays for the same checksum
+void Application::benchMath()
+{
+	volatile float zero = 0.0f, one = 1.0f, angle = 1.0f;
+	volatile float sink = 0.0f;
+
+	const Mat4f a = Mat4f::translate(Vec3f(one, zero, one)), b = Mat4f::ortho(zero, one, zero, one, -one, one);
+
+	const char *names[] = { "constant ortho", "runtime ortho", "runtime perspective", "runtime multiply" };
+	double ns[4];
+
+	ns[0] = timeMath([&]() { sink = sink + checksum(QUAD_PROJECTION); });
+	ns[1] = timeMath([&]() { sink = sink + checksum(Mat4f::ortho(zero, one, zero, one, -one, one)); });
+	ns[2] = timeMath([&]() { sink = sink + checksum(Mat4f::perspective(angle, one, one, one + one)); });
+	ns[3] = timeMath([&]() { sink = sink + checksum(a * b); });
+
+	printf("Math bench: %d calls each, checksum included\n", MATH_BENCH_ITERATIONS);
+	printf("%-20s %10s %10s\n", "case", "ns/call", "vs const");
+
+	for (int i = 0; i < 4; ++i)
+		printf("%-20s %10.2f %9.2fx\n", names[i], ns[i], ns[i] / ns[0]);
+}
+
+// converts a binary ppm into a .gtex for --texture, or with a number for the
+// source writes a test pattern that size. gl rows go bottom up, so do these
+bool Application::makeTexture()
+{
+	std::vector<unsigned char> rgba;
+	int width = atoi(textureSource.c_str()), height = width;
+
+	if (width > 0)
+	{
+		rgba.resize((size_t)width * height * 4);
+		for (int y = 0; y < height; ++y)
+		{
+			for (int x = 0; x < width; ++x)
+			{
+				// gradients with a checker, and a fine grid that only the
+				// full resolution levels resolve
+				unsigned char *pixel = &rgba[((size_t)y * width + x) * 4];
+				const bool checker = ((x / 64) + (y / 64)) % 2 == 0;
+				const bool grid = x % 8 == 0 || y % 8 == 0;
+				pixel[0] = (unsigned char)(x * 255 / std::max(1, width - 1));
+				pixel[1] = (unsigned char)(y * 255 / std::max(1, height - 1));
+				pixel[2] = checker ? 200 : 60;
+				pixel[3] = 255;
+
+				if (grid)
+					pixel[0] = pixel[1] = pixel[2] = 255;
+			}
+		}
+	}
+	else
+	{
+		FILE *file = fopen(textureSource.c_str(), "rb");
+		if (!file)
+		{
+			printf("Failed to open %s!\n", textureSource.c_str());
+			return false;
+		}
+
+		int maximum = 0;
+		if (fscanf(file, "P6 %d %d %d", &width, &height, &maximum) != 3 || width <= 0 || height <= 0 || maximum != 255 ||
+			fgetc(file) == EOF)
+		{
+			printf("%s is not an 8 bit binary ppm!\n", textureSource.c_str());
+			fclose(file);
+			return false;
+		}
+
+		std::vector<unsigned char> rgb((size_t)width * height * 3);
+		const bool complete = fread(&rgb[0], 1, rgb.size(), file) == rgb.size();
+		fclose(file);
+
+		if (!complete)
+		{
+			printf("%s is cut short!\n", textureSource.c_str());
+			return false;
+		}
+
+		rgba.resize((size_t)width * height * 4);
+		for (int y = 0; y < height; ++y)
+		{
+			const unsigned char *row = &rgb[(size_t)(height - 1 - y) * width * 3];
+			for (int x = 0; x < width; ++x)
+			{
+				unsigned char *pixel = &rgba[((size_t)y * width + x) * 4];
+				pixel[0] = row[x * 3];
+				pixel[1] = row[x * 3 + 1];
+				pixel[2] = row[x * 3 + 2];
+				pixel[3] = 255;
+			}
+		}
+	}
+
+	if (!TextureFile::write(textureOutput.c_str(), rgba, width, height, TEXTURE_FILE_TILE))
+		return false;
+
+	printf("Wrote %s, %dx%d\n", textureOutput.c_str(), width, height);
 	return true;
 }
 
+// renders the scene on several windows or offscreen targets at once, each
+// with its own context and render thread. the program and the quad buffers
+// are shared from the main context
+void Application::runContexts()
+{
+	const int tier = governor.getTier();
+
+	Shader *scene = shaders.get("basic.vert", "basic.frag", QualityGovernor::tier(tier).defines() + "#define FRAME_BLOCK\n");
+	if (!scene || scene->getUniformLocation("u_ModelViewProjectionMatrix") == -1 ||
+		!scene->bindUniformBlock("Frame", CONTEXT_FRAME_BINDING))
+	{
+		printf("Failed to build the context scene!\n");
+		return;
+	}
+
+	// the same for every context, so it can live in the shared program
+	scene->bind();
+	scene->setUniformMatrix4fv("u_ModelViewProjectionMatrix", 1, GL_FALSE, QUAD_PROJECTION.m);
+
+	// shared objects have to be complete before another context uses them
+	glFinish();
+
+	int frames = contextFrames;
+	if (frames == 0 && (contextOffscreen || contextScaling))
+		frames = CONTEXT_DEFAULT_FRAMES;
+
+	printf("Contexts: %d %s at %dx%d, %s tier, %d hardware threads\n", contextCount, contextOffscreen ? "offscreen" : "windows",
+		contextWidth, contextHeight, QualityGovernor::tier(tier).name, (int)std::thread::hardware_concurrency());
+
+	if (!contextScaling)
+	{
+		renderContexts(*scene, contextCount, frames, true);
+		return;
+	}
+
+	printf("%-8s %10s %10s %10s %11s\n", "contexts", "frames/s", "Mpix/s", "speedup", "efficiency");
+
+	// doubling, and the requested count last when doubling skips it
+	double baseRate = 0.0;
+	for (int count = 1;; count = std::min(count * 2, contextCount))
+	{
+		const ContextStats total = renderContexts(*scene, count, frames, false);
+		if (total.seconds <= 0.0)
+			return;
+
+		const double rate = total.frames / total.seconds;
+		if (count == 1)
+			baseRate = rate;
+
+		printf("%-8d %10.1f %10.1f %9.2fx %10.1f%%\n", count, rate, total.pixels / total.seconds / 1000000.0,
+			rate / baseRate, 100.0 * rate / baseRate / count);
+
+		if (count == contextCount)
+			break;
+	}
+}
+
+// runs count contexts until they are done and returns their sum, with the
+// wall time in seconds
+ContextStats Application::renderContexts(Shader &scene, int count, int frames, bool report)
+{
+	std::vector<RenderContext*> contexts;
+	ContextStats total;
+	bool created = true;
+
+	for (int i = 0; i < count && created; ++i)
+	{
+		contexts.push_back(new RenderContext());
+		if ((created = contexts.back()->create(i, window, contextOffscreen, contextWidth, contextHeight)))
+			glfwSetKeyCallback(contexts.back()->getWindow(), key_callback);
+	}
+
+	if (created)
+	{
+		const double start = glfwGetTime();
+
+		for (std::vector<RenderContext*>::iterator i = contexts.begin(); i != contexts.end(); ++i)
+			(*i)->start(scene, quad, frames);
+
+		// events and window sizes are main thread only in glfw
+		for (bool running = true; running;)
+		{
+			running = false;
+			for (std::vector<RenderContext*>::iterator i = contexts.begin(); i != contexts.end(); ++i)
+			{
+				(*i)->updateSize();
+				running = running || (*i)->isRunning();
+			}
+
+			glfwPollEvents();
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		}
+
+		for (std::vector<RenderContext*>::iterator i = contexts.begin(); i != contexts.end(); ++i)
+			(*i)->join();
+
+		total.seconds = glfwGetTime() - start;
+	}
+
+	if (created && report)
+		printf("%-8s %-10s %8s %10s %10s %10s %10s %10s\n", "context", "target", "frames", "fps", "cpu ms", "worst ms", "gpu ms", "Mpix/s");
+
+	for (std::vector<RenderContext*>::iterator i = contexts.begin(); i != contexts.end(); ++i)
+	{
+		const ContextStats &stats = (*i)->getStats();
+		total.frames += stats.frames;
+		total.pixels += stats.pixels;
+
+		if (created && report && stats.seconds > 0.0)
+			printf("%-8d %-10s %8d %10.1f %10.2f %10.2f %10.2f %10.1f\n", (*i)->getIndex(), (*i)->isOffscreen() ? "offscreen" : "window",
+				stats.frames, stats.frames / stats.seconds, stats.cpuMs, stats.worstMs, stats.gpuMs, stats.pixels / stats.seconds / 1000000.0);
+
+		delete *i;
+	}
+
+	if (created && report && total.seconds > 0.0)
+		printf("%-8s %-10s %8d %10.1f %10s %10s %10s %10.1f\n", "total", "", total.frames, total.frames / total.seconds,
+			"", "", "", total.pixels / total.seconds / 1000000.0);
+
+	return total;
+}
+
+// the render farm coordinator, the cpu workers and the job and math benches
+// get by without a context
+bool Application::usesGL() const
+{
+	if (farm.workers > 0 || jobBench || mathBench || !textureOutput.empty())
+		return false;
+
+	return workerAddress.empty() || workerGL;
+}
+
+// grows the target that farm tiles and cpu frames go through
+bool Application::resizeTileTarget(int width, int height)
+{
+	if (width <= tileWidth && height <= tileHeight)
+		return true;
+
+	tileWidth = std::max(tileWidth, width);
+	tileHeight = std::max(tileHeight, height);
+
+	if (!tileTexture.get())
+	{
+		tileTexture.create();
+		tileFramebuffer.create();
+	}
+
+	glBindTexture(GL_TEXTURE_2D, tileTexture.get());
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, tileWidth, tileHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	tileTexture.setBytes(textureBytes(GL_RGBA8, tileWidth, tileHeight));
+
+	glBindFramebuffer(GL_FRAMEBUFFER, tileFramebuffer.get());
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, tileTexture.get(), 0);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	{
+		printf("Failed to create the tile target!\n");
+		return false;
+	}
+
+	return true;
+}
+
+// the viewport is offset so the tile's part of the frame lands in a tile
+// sized target, the scene shader doesn't need to know about tiles
+bool Application::renderTile(const TileJob &job, unsigned char *rgb)
+{
+	if ((int)job.tier >= QualityGovernor::tierCount())
+		return false;
+
+	if (!resizeTileTarget(job.w, job.h))
+		return false;
+
+	glBindFramebuffer(GL_FRAMEBUFFER, tileFramebuffer.get());
+	glViewport(-(int)job.x, -(int)job.y, job.width, job.height);
+	drawScene(*tierShaders[job.tier].scene, job.width, job.height, job.time);
+
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0, 0, job.w, job.h, GL_RGB, GL_UNSIGNED_BYTE, rgb);
+
+	return glGetError() == GL_NO_ERROR;
+}
+
 // the app is worth running if the initialization returns true
-void Application::run()
+bool Application::run()
 {
+	if (jobBench)
+	{
+		benchJobs();
+		return true;
+	}
+
+	if (vertexBench)
+	{
+		benchVertex();
+		return true;
+	}
+
+	if (mathBench)
+	{
+		benchMath();
+		return true;
+	}
+
+	if (!textureOutput.empty())
+	{
+		return makeTexture();
+	}
+
+	if (farm.workers > 0)
+	{
+		// sequences get the best tier unless one was asked for
+		farm.tier = governor.getTier();
+
+		RenderFarm coordinator;
+		return coordinator.run(farm);
+	}
+
+	if (!workerAddress.empty())
+	{
+		if (workerGL)
+		{
+			return RenderFarm::work(workerAddress.c_str(), *this, workerFailAfter);
+		}
+
+		CpuRenderer renderer;
+		return RenderFarm::work(workerAddress.c_str(), renderer, workerFailAfter);
+	}
+
+	if (aaReport)
+	{
+		reportAA();
+		return true;
+	}
+
+	if (computeBench)
+	{
+		benchCompute();
+		return true;
+	}
+
+	if (contextCount > 0)
+	{
+		runContexts();
+		return true;
+	}
+
+	if (progressiveWidth > 0)
+	{
+		// a still shouldn't catch the placeholder mips
+		while (streamer.isStreaming())
+			streamer.update(0.0);
+
+		runProgressive();
+	}
+
+	JobSystem &jobs = JobSystem::getInstance();
+	jobs.resetStats();
+
+	double lastFrame = glfwGetTime();
+	gpuMs = 0.0;
+
 	while (!glfwWindowShouldClose(window))
 	{
+		const double frameStart = glfwGetTime();
+
 		int width, height;
 		glfwGetFramebufferSize(window, &width, &height);
-		float ratio = width / (float)height;
-		
-		// set viewport accordingly
-		glViewport(0, 0, width, height);
 
-		//clear it out
-		glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
-		glClear(GL_COLOR_BUFFER_BIT);
+		// cpu work for the frame goes out first and is joined right before the
+		// draw, the main thread does its own work meanwhile and helps after
+		Job cpuFrame;
+		const int cpuWidth = std::max(1, width / CPU_PREVIEW_DIVISOR), cpuHeight = std::max(1, height / CPU_PREVIEW_DIVISOR);
+		if (cpuPreview)
+		{
+			const int tier = governor.getTier();
+			cpuFrame.setWork([=]() { renderCpu(cpuImage, cpuWidth, cpuHeight, tier, (float)frameStart); });
+			jobs.submit(cpuFrame);
+		}
 
-		const Mat4f u_ModelViewProjectionMatrix = Mat4f::ortho(0.0f, 1.0f, 0.0f, 1.0f, -1.0f, 1.0f);
+		updateQuality((frameStart - lastFrame) * 1000.0);
+		streamer.update((frameStart - lastFrame) * 1000.0);
+		lastFrame = frameStart;
 
-		shader.bind();
-		shader.setUniformMatrix4fv("u_ModelViewProjectionMatrix", 1, GL_FALSE, u_ModelViewProjectionMatrix.m);
-		shader.setUniform1f("u_Time", glfwGetTime());
-		shader.setUniform2f("u_Resolution", width, height);
-		//printf("%f\n", glfwGetTime());
+		frameTimer.begin();
 
-		// vertex attribute
-		glEnableVertexAttribArray(0);
-		glBindBuffer(GL_ARRAY_BUFFER, VBO);
-		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, 0);
+		if (cpuPreview)
+		{
+			jobs.wait(cpuFrame);
+			presentCpu(cpuWidth, cpuHeight, width, height);
+		}
+		else if (useCompute)
+		{
+			compute.resize(width, height);
+			compute.dispatch(*tierShaders[governor.getTier()].compute, (float)glfwGetTime());
+			compute.present();
+		}
+		else
+			renderFrame(aaMode, width, height, (float)glfwGetTime());
 
-		// texture coordinate attribute
-		glEnableVertexAttribArray(1);
-		glBindBuffer(GL_ARRAY_BUFFER, uvBuffer);
-		glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 0, 0);
-
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, IBO);
-		glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-		glDisableVertexAttribArray(0);
+		frameTimer.end();
 
 		glfwSwapBuffers(window);
 		glfwPollEvents();
 	}
+
+	if (background)
+		streamer.report();
+
+	if (jobs.getJobCount() > 0)
+		jobs.report();
+
+	return true;
 }
\ No newline at end of file
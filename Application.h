@@ -3,38 +3,159 @@
 
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
+#include "AdaptiveAA.h"
+#include "ComputeRaymarcher.h"
+#include "GLResource.h"
+#include "GpuTimer.h"
+#include "JobSystem.h"
+#include "Mesh.h"
+#include "ProgressiveRenderer.h"
+#include "QualityGovernor.h"
+#include "RenderContext.h"
+#include "RenderFarm.h"
 #include "Shader.h"
+#include "ShaderCache.h"
 #include "Singleton.h"
+#include "TextureStreamer.h"
+#include "TileRenderer.h"
 #include "Vec2.h"
 #include "Vec3.h"
+#include "VertexFormat.h"
 
-class Application : public Singleton<Application>
+enum AAMode
 {
+	AA_OFF,			// one sample per pixel
+	AA_ADAPTIVE,	// extra samples only where AdaptiveAA finds edges
+	AA_SUPERSAMPLE	// extra samples for every pixel
+};
+
+// fullscreen quad: position, texture coordinate
+typedef VertexLayout<Vec2<unsigned char>, Vec2<unsigned char> > QuadLayout;
+
+// --bench-vertex meshes: position, normal, texture coordinate
+typedef VertexLayout<Vec3f, Vec3f, Vec2f> FloatMeshLayout;
+typedef VertexLayout<Vec3h, Vec3<signed char>, Vec2<unsigned short> > CompactMeshLayout;
+
+// programs for one quality tier, the AA ones are only built when needed
+struct TierShaders
+{
+	Shader *scene;
+	Shader *gbuffer;
+	Shader *supersample;
+	Shader *refine;
+	Shader *compute;
+};
+
+class Application : public Singleton<Application>, public TileRenderer
+{
+	friend class Singleton<Application>;
+
 public:
 	~Application();
 
 	bool initialize(int argc, char *argv[]);
-	void run();
+
+	// false if the mode failed, the farm and its workers report it in the
+	// exit code
+	bool run();
+
+	// render farm tiles on the gpu, for --worker-gl
+	bool renderTile(const TileJob &job, unsigned char *rgb);
 
 private:
 	static void error_callback(int error, const char* description);
 	static void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods);
 
+	bool parseArgs(int argc, char *argv[]);
 	bool initGLFW(); 
 	bool initGLEW(); 
 	bool initShader(); 
+	Shader *initScene(int tier, const std::string &defines);
+	Shader *initCompute(int tier, const std::string &defines);
+	bool initUniforms(Shader &shader);
 	bool initContent();
 
+	void updateQuality(double frameMs);
+	void drawQuad();
+	void drawScene(Shader &shader, int width, int height, float time);
+	void renderFrame(AAMode mode, int width, int height, float time);
+	void reportAA();
+	void runProgressive();
+	void benchCompute();
+	void renderCpu(std::vector<unsigned char> &rgb, int width, int height, int tier, float time);
+	void presentCpu(int width, int height, int windowWidth, int windowHeight);
+	void benchJobs();
+	void benchVertex();
+	void benchMath();
+	bool makeTexture();
+	void runContexts();
+	ContextStats renderContexts(Shader &scene, int count, int frames, bool report);
+	bool resizeTileTarget(int width, int height);
+	bool usesGL() const;
+
+	Application();
+
 	GLFWwindow* window;
-	Shader shader;
-	std::vector<Vec3f> vertices;
-	std::vector<Vec2f> texCoords;
-	std::vector<GLuint> indices;
-	GLuint vertexArray, VBO, uvBuffer, IBO;
+	ShaderCache shaders;
+	std::vector<TierShaders> tierShaders; // one set of permutations per quality tier
+	QualityGovernor governor;
+	AAMode aaMode;
+	int aaSamples;
+	bool aaReport;
+	AdaptiveAA aa;
+	int progressiveWidth, progressiveHeight;
+	int progressiveSamples;
+	float progressiveNoise;
+	std::string progressiveOutput;
+	ProgressiveRenderer progressive;
+	bool useCompute;
+	bool computeBench;
+	ComputeRaymarcher compute;
+	FarmSettings farm;
+	std::string workerAddress;
+	bool workerGL;
+	int workerFailAfter;
+	GLFramebuffer tileFramebuffer;
+	GLTexture tileTexture;
+	int tileWidth, tileHeight;
+	int jobThreads;
+	bool jobBench;
+	bool cpuPreview;
+	bool vertexBench;
+	bool mathBench;
+	int contextCount;
+	bool contextOffscreen;
+	int contextFrames;
+	int contextWidth, contextHeight;
+	bool contextScaling;
+	bool glStats;
+	std::string texturePath;
+	std::string textureSource, textureOutput;	// --make-texture
+	TextureStreamer streamer;
+	StreamedTexture *background;
+	std::string sceneDefines;
+	std::vector<unsigned char> cpuImage;
+	GpuTimer frameTimer;
+	double gpuMs;
+	Mesh quad;
 };
 
 
 #define INIT_WIDTH 640
 #define INIT_HEIGHT 480
 
+#define AA_REFERENCE_SAMPLES 16	// samples per pixel of the --aa-report ground truth
+#define AA_REPORT_FRAMES 8		// frames averaged per mode in --aa-report
+#define COMPUTE_BENCH_FRAMES 5	// frames averaged per path and size in --bench-compute
+
+#define CPU_PREVIEW_DIVISOR 4	// --cpu renders at a quarter of the window size per axis
+#define CPU_ROWS_PER_JOB 4		// rows per parallelFor range of the cpu renderer
+#define JOB_BENCH_WIDTH 320
+#define JOB_BENCH_HEIGHT 240
+#define JOB_BENCH_FRAMES 3		// frames averaged per thread count in --bench-jobs
+#define JOB_BENCH_EMPTY 65536	// empty jobs timed for the scheduling overhead
+#define VERTEX_BENCH_DRAWS 10	// draws averaged per mesh in --bench-vertex
+#define MATH_BENCH_ITERATIONS 10000000	// calls timed per case in --bench-math
+#define BACKGROUND_TEXTURE_UNIT 1		// --texture, unit 0 stays free for the AA passes
+
 #endif
\ No newline at end of file
@@ -0,0 +1,93 @@
+#include "ComputeRaymarcher.h"
+
+#include <stdio.h>
+
+ComputeRaymarcher::ComputeRaymarcher() : width(0), height(0) {}
+
+ComputeRaymarcher::~ComputeRaymarcher()
+{
+	release();
+}
+
+bool ComputeRaymarcher::isSupported()
+{
+	return GLEW_VERSION_4_3 != 0;
+}
+
+void ComputeRaymarcher::release()
+{
+	fbo.reset();
+	image.reset();
+}
+
+// (re)create the image when the framebuffer size changes
+void ComputeRaymarcher::resize(int width, int height)
+{
+	if (image.get() && width == this->width && height == this->height)
+		return;
+
+	release();
+	this->width = width;
+	this->height = height;
+
+	// immutable storage, image units need a complete texture
+	image.create();
+	glBindTexture(GL_TEXTURE_2D, image.get());
+	glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, width, height);
+	image.setBytes(textureBytes(GL_RGBA8, width, height));
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	fbo.create();
+	glBindFramebuffer(GL_FRAMEBUFFER, fbo.get());
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, image.get(), 0);
+
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		printf("Compute framebuffer is incomplete!\n");
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void ComputeRaymarcher::dispatch(Shader &shader, float time)
+{
+	shader.bind();
+	shader.setUniform1f("u_Time", time);
+	shader.setUniform2f("u_Resolution", width, height);
+
+	glBindImageTexture(0, image.get(), 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA8);
+	glDispatchCompute((width + COMPUTE_TILE_SIZE - 1) / COMPUTE_TILE_SIZE,
+		(height + COMPUTE_TILE_SIZE - 1) / COMPUTE_TILE_SIZE, 1);
+
+	// the blit reads the image through the framebuffer
+	glMemoryBarrier(GL_FRAMEBUFFER_BARRIER_BIT);
+}
+
+void ComputeRaymarcher::present()
+{
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo.get());
+	glReadBuffer(GL_COLOR_ATTACHMENT0);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+	glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void ComputeRaymarcher::bindTarget()
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, fbo.get());
+	glViewport(0, 0, width, height);
+}
+
+void ComputeRaymarcher::readColor(unsigned char *rgba) const
+{
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo.get());
+	glReadBuffer(GL_COLOR_ATTACHMENT0);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, rgba);
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+}
+
+int ComputeRaymarcher::getWidth() const { return width; }
+
+int ComputeRaymarcher::getHeight() const { return height; }
@@ -0,0 +1,42 @@
+#ifndef COMPUTERAYMARCHER_H
+#define COMPUTERAYMARCHER_H
+
+#include <GL/glew.h>
+#include "GLResource.h"
+#include "Shader.h"
+
+#define COMPUTE_TILE_SIZE 8 // matches local_size in raymarch.comp
+
+// runs raymarch.comp into an image and blits it to the window, the GL 4.3
+// alternative to drawing basic.frag over the fullscreen quad
+class ComputeRaymarcher
+{
+public:
+	ComputeRaymarcher();
+	~ComputeRaymarcher();
+
+	static bool isSupported();
+
+	void release();
+	void resize(int width, int height);
+
+	void dispatch(Shader &shader, float time);
+	void present();
+
+	// the image as a render target, so the fragment path can be timed against it
+	void bindTarget();
+	void readColor(unsigned char *rgba) const;
+
+	int getWidth() const;
+	int getHeight() const;
+
+private:
+	ComputeRaymarcher(const ComputeRaymarcher &);
+	ComputeRaymarcher &operator = (const ComputeRaymarcher &);
+
+	GLTexture image;
+	GLFramebuffer fbo;
+	int width, height;
+};
+
+#endif
@@ -0,0 +1,140 @@
+#include "CpuRenderer.h"
+
+#include <math.h>
+
+#define CPU_REPEAT 0.15f
+#define CPU_EPSILON 0.001f
+
+static const Vec3f camPosition(0.0f, 0.0f, 2.0f);
+
+CpuRenderer::CpuRenderer() : tier(&QualityGovernor::tier(0)), boxSize(0.0f), lightZ(0.0f) {}
+
+bool CpuRenderer::renderTile(const TileJob &job, unsigned char *rgb)
+{
+	if ((int)job.tier >= QualityGovernor::tierCount())
+		return false;
+
+	tier = &QualityGovernor::tier(job.tier);
+	setTime(job.time);
+
+	const float aspect = (float)job.width / job.height;
+
+	for (unsigned int y = 0; y < job.h; ++y)
+	{
+		// pixel centres, like the interpolated v_uv
+		const float v = (job.y + y + 0.5f) / job.height;
+
+		for (unsigned int x = 0; x < job.w; ++x)
+		{
+			const float u = (job.x + x + 0.5f) / job.width;
+			const float color = render(u, v, aspect);
+
+			// unorm conversion of an rgba8 target
+			const float clamped = color < 0.0f ? 0.0f : (color > 1.0f ? 1.0f : color);
+			const unsigned char value = (unsigned char)(clamped * 255.0f + 0.5f);
+
+			rgb[0] = rgb[1] = rgb[2] = value;
+			rgb += 3;
+		}
+	}
+
+	return true;
+}
+
+// makeRotation(u_Time, 1, 1, 1) as rows, the glsl one is built column wise
+void CpuRenderer::setTime(float time)
+{
+	const float axis = 1.0f / sqrtf(3.0f);
+	const float c = cosf(time), cp = 1.0f - c, s = sinf(time);
+	const float diagonal = c + cp * axis * axis;
+	const float plus = cp * axis * axis + axis * s;
+	const float minus = cp * axis * axis - axis * s;
+
+	rotation[0][0] = diagonal; rotation[0][1] = plus; rotation[0][2] = minus;
+	rotation[1][0] = minus; rotation[1][1] = diagonal; rotation[1][2] = plus;
+	rotation[2][0] = plus; rotation[2][1] = minus; rotation[2][2] = diagonal;
+
+	boxSize = 0.015f * (sinf(time) + 1.5f);
+	lightZ = -(sinf(time) + 1.0f);
+}
+
+// glsl mod, the result takes the sign of c
+static float repeat(float p, float c)
+{
+	return p - c * floorf(p / c) - 0.5f * c;
+}
+
+float CpuRenderer::scene(const Vec3f &p) const
+{
+	const float qx = repeat(p.x, CPU_REPEAT), qy = repeat(p.y, CPU_REPEAT), qz = repeat(p.z, CPU_REPEAT);
+
+	// sdBox
+	float d[3];
+	for (int i = 0; i < 3; ++i)
+		d[i] = fabsf(rotation[i][0] * qx + rotation[i][1] * qy + rotation[i][2] * qz) - boxSize;
+
+	const float inside = fminf(fmaxf(d[0], fmaxf(d[1], d[2])), 0.0f);
+	const Vec3f outside(fmaxf(d[0], 0.0f), fmaxf(d[1], 0.0f), fmaxf(d[2], 0.0f));
+	return inside + Vec3f::length(outside);
+}
+
+Vec3f CpuRenderer::calcNormal(const Vec3f &p) const
+{
+	const float h = CPU_EPSILON;
+
+	if (tier->normalTaps == 4)
+	{
+		const float a = scene(Vec3f(p.x + h, p.y - h, p.z - h));
+		const float b = scene(Vec3f(p.x - h, p.y - h, p.z + h));
+		const float c = scene(Vec3f(p.x - h, p.y + h, p.z - h));
+		const float d = scene(Vec3f(p.x + h, p.y + h, p.z + h));
+
+		return Vec3f::normalize(Vec3f(a - b - c + d, -a - b + c + d, -a + b - c + d));
+	}
+
+	return Vec3f::normalize(Vec3f(scene(Vec3f(p.x + h, p.y, p.z)) - scene(Vec3f(p.x - h, p.y, p.z)),
+		scene(Vec3f(p.x, p.y + h, p.z)) - scene(Vec3f(p.x, p.y - h, p.z)),
+		scene(Vec3f(p.x, p.y, p.z + h)) - scene(Vec3f(p.x, p.y, p.z - h))));
+}
+
+// every ray is shaded where it stops, even one that ran out of depth
+float CpuRenderer::intersect(const Vec3f &origin, const Vec3f &direction) const
+{
+	float rayLength = 0.0f;
+
+	for (int i = 0; i < tier->maxSteps; ++i)
+	{
+		if (rayLength > tier->maxDepth)
+			break;
+
+		const float distance = scene(direction * rayLength + origin);
+		if (distance < CPU_EPSILON)
+			break;
+
+		// partially increment to reduce artifacts
+		rayLength += tier->stepFactor * distance;
+	}
+
+	return rayLength;
+}
+
+// the scene is grey, so one channel is enough
+float CpuRenderer::render(float u, float v, float aspect) const
+{
+	// cameraRay
+	const float px = (u * 2.0f - 1.0f) * aspect, py = v * 2.0f - 1.0f;
+	const Vec3f direction = Vec3f::normalize(Vec3f(px, py, -1.5f));
+
+	const float dist = intersect(camPosition, direction);
+	const float att = 1.0f / (2.0f + dist * (1.0f + 0.5f * dist));
+
+	const Vec3f position = camPosition + direction * dist;
+	const Vec3f normal = calcNormal(position);
+	const Vec3f light = Vec3f::normalize(position + Vec3f(0.0f, 0.8f, lightZ));
+	const Vec3f reflected = direction - normal * (2.0f * Vec3f::dotProduct(normal, direction));
+
+	const float lightDotR = Vec3f::dotProduct(light, reflected);
+	const float specular = 0.5f * powf(lightDotR < 0.0f ? 0.0f : (lightDotR > 1.0f ? 1.0f : lightDotR), 8.0f);
+
+	return 0.75f * att + fmaxf(0.0f, Vec3f::dotProduct(normal, light)) * att + specular * att;
+}
@@ -0,0 +1,34 @@
+#ifndef CPURENDERER_H
+#define CPURENDERER_H
+
+#include "QualityGovernor.h"
+#include "TileRenderer.h"
+#include "Vec3.h"
+
+// scene.glsl ported to c++, so render farm workers don't need a gpu. follows
+// the single sample path of basic.frag, images match the gl path to within
+// float precision
+class CpuRenderer : public TileRenderer
+{
+public:
+	CpuRenderer();
+
+	bool renderTile(const TileJob &job, unsigned char *rgb);
+
+private:
+	// everything that only depends on the frame time, the shader recomputes
+	// it for every distance evaluation
+	void setTime(float time);
+
+	float scene(const Vec3f &p) const;
+	Vec3f calcNormal(const Vec3f &p) const;
+	float intersect(const Vec3f &origin, const Vec3f &direction) const;
+	float render(float u, float v, float aspect) const;
+
+	const QualityTier *tier;
+	float rotation[3][3];
+	float boxSize;
+	float lightZ;
+};
+
+#endif
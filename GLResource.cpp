@@ -0,0 +1,195 @@
+#include "GLResource.h"
+
+#include <stdio.h>
+
+static const char *names[RESOURCE_TYPE_COUNT] =
+{
+	"buffers", "vertex arrays", "textures", "renderbuffers", "framebuffers", "programs", "shaders", "queries"
+};
+
+const char *GLResourceRegistry::name(GLResourceType type)
+{
+	return names[type];
+}
+
+GLResourceRegistry::GLResourceRegistry() : totalBytes(0), peakTotalBytes(0), budget(0), overBudget(false)
+{
+	for (int i = 0; i < RESOURCE_TYPE_COUNT; ++i)
+	{
+		categories[i].count = categories[i].peakCount = 0;
+		categories[i].bytes = categories[i].peakBytes = 0;
+	}
+}
+
+void GLResourceRegistry::created(GLResourceType type)
+{
+	std::lock_guard<std::mutex> guard(lock);
+
+	Category &category = categories[type];
+	if (++category.count > category.peakCount)
+		category.peakCount = category.count;
+}
+
+void GLResourceRegistry::destroyed(GLResourceType type, size_t bytes)
+{
+	std::lock_guard<std::mutex> guard(lock);
+
+	Category &category = categories[type];
+	--category.count;
+	category.bytes -= bytes;
+	updateTotal(bytes, 0);
+}
+
+void GLResourceRegistry::resized(GLResourceType type, size_t oldBytes, size_t newBytes)
+{
+	std::lock_guard<std::mutex> guard(lock);
+
+	Category &category = categories[type];
+	category.bytes += newBytes - oldBytes;
+	if (category.bytes > category.peakBytes)
+		category.peakBytes = category.bytes;
+
+	updateTotal(oldBytes, newBytes);
+}
+
+// lock held
+void GLResourceRegistry::updateTotal(size_t oldBytes, size_t newBytes)
+{
+	totalBytes += newBytes - oldBytes;
+	if (totalBytes > peakTotalBytes)
+		peakTotalBytes = totalBytes;
+
+	if (budget && totalBytes > budget && !overBudget)
+	{
+		printf("GL memory over budget: %.2f MB of %.2f MB!\n", totalBytes / 1048576.0, budget / 1048576.0);
+		overBudget = true;
+	}
+	else if (totalBytes <= budget)
+		overBudget = false;
+}
+
+void GLResourceRegistry::setBudget(size_t bytes)
+{
+	std::lock_guard<std::mutex> guard(lock);
+	budget = bytes;
+	overBudget = false;
+}
+
+int GLResourceRegistry::getCount(GLResourceType type) const
+{
+	std::lock_guard<std::mutex> guard(lock);
+	return categories[type].count;
+}
+
+size_t GLResourceRegistry::getBytes(GLResourceType type) const
+{
+	std::lock_guard<std::mutex> guard(lock);
+	return categories[type].bytes;
+}
+
+int GLResourceRegistry::getPeakCount(GLResourceType type) const
+{
+	std::lock_guard<std::mutex> guard(lock);
+	return categories[type].peakCount;
+}
+
+size_t GLResourceRegistry::getPeakBytes(GLResourceType type) const
+{
+	std::lock_guard<std::mutex> guard(lock);
+	return categories[type].peakBytes;
+}
+
+size_t GLResourceRegistry::getTotalBytes() const
+{
+	std::lock_guard<std::mutex> guard(lock);
+	return totalBytes;
+}
+
+size_t GLResourceRegistry::getPeakTotalBytes() const
+{
+	std::lock_guard<std::mutex> guard(lock);
+	return peakTotalBytes;
+}
+
+void GLResourceRegistry::report() const
+{
+	std::lock_guard<std::mutex> guard(lock);
+
+	printf("GL resources: %.2f MB live, %.2f MB peak\n", totalBytes / 1048576.0, peakTotalBytes / 1048576.0);
+	printf("%-14s %8s %10s %8s %10s\n", "category", "live", "MB", "peak", "peak MB");
+
+	for (int i = 0; i < RESOURCE_TYPE_COUNT; ++i)
+	{
+		const Category &category = categories[i];
+		printf("%-14s %8d %10.2f %8d %10.2f\n", names[i], category.count, category.bytes / 1048576.0,
+			category.peakCount, category.peakBytes / 1048576.0);
+	}
+}
+
+bool GLResourceRegistry::checkLeaks() const
+{
+	std::lock_guard<std::mutex> guard(lock);
+
+	bool clean = true;
+	for (int i = 0; i < RESOURCE_TYPE_COUNT; ++i)
+	{
+		if (categories[i].count == 0)
+			continue;
+
+		printf("Leaked %d %s (%.2f MB)!\n", categories[i].count, names[i], categories[i].bytes / 1048576.0);
+		clean = false;
+	}
+
+	return clean;
+}
+
+// only the formats this program creates need to be here
+static size_t pixelBytes(GLenum internalFormat)
+{
+	switch (internalFormat)
+	{
+	case GL_R8:
+		return 1;
+	case GL_R16F:
+	case GL_RG8:
+		return 2;
+	case GL_RGB8:
+		return 3;
+	case GL_RGBA8:
+	case GL_SRGB8_ALPHA8:
+	case GL_R32F:
+	case GL_RG16F:
+	case GL_DEPTH24_STENCIL8:
+	case GL_DEPTH_COMPONENT24:
+		return 4;
+	case GL_RGBA16F:
+	case GL_RG32F:
+		return 8;
+	case GL_RGBA32F:
+		return 16;
+	default:
+		return 4;
+	}
+}
+
+size_t textureBytes(GLenum internalFormat, int width, int height, int levels)
+{
+	size_t bytes = 0;
+	for (int level = 0; level < levels && (width > 0 || height > 0); ++level)
+	{
+		bytes += (size_t)(width > 0 ? width : 1) * (height > 0 ? height : 1) * pixelBytes(internalFormat);
+		width /= 2;
+		height /= 2;
+	}
+
+	return bytes;
+}
+
+int mipLevels(int width, int height)
+{
+	int levels = 1;
+	for (int size = width > height ? width : height; size > 1; size /= 2)
+		++levels;
+
+	return levels;
+}
@@ -0,0 +1,238 @@
+#ifndef GLRESOURCE_H
+#define GLRESOURCE_H
+
+#include <GL/glew.h>
+#include <mutex>
+#include <stddef.h>
+#include "Singleton.h"
+
+enum GLResourceType
+{
+	RESOURCE_BUFFER,
+	RESOURCE_VERTEX_ARRAY,
+	RESOURCE_TEXTURE,
+	RESOURCE_RENDERBUFFER,
+	RESOURCE_FRAMEBUFFER,
+	RESOURCE_PROGRAM,
+	RESOURCE_SHADER,
+	RESOURCE_QUERY,
+	RESOURCE_TYPE_COUNT
+};
+
+// live gl objects and the memory behind them per category, with high water
+// marks. fed by GLHandle, safe to use from several threads
+class GLResourceRegistry : public Singleton<GLResourceRegistry>
+{
+	friend class Singleton<GLResourceRegistry>;
+
+public:
+	static const char *name(GLResourceType type);
+
+	void created(GLResourceType type);
+	void destroyed(GLResourceType type, size_t bytes);
+	void resized(GLResourceType type, size_t oldBytes, size_t newBytes);
+
+	// warns once when the tracked memory goes over, 0 turns it off
+	void setBudget(size_t bytes);
+
+	int getCount(GLResourceType type) const;
+	size_t getBytes(GLResourceType type) const;
+	int getPeakCount(GLResourceType type) const;
+	size_t getPeakBytes(GLResourceType type) const;
+	size_t getTotalBytes() const;
+	size_t getPeakTotalBytes() const;
+
+	void report() const;
+
+	// prints every category with objects still alive, call once everything
+	// should have been released. true if nothing leaked
+	bool checkLeaks() const;
+
+private:
+	struct Category
+	{
+		int count, peakCount;
+		size_t bytes, peakBytes;
+	};
+
+	GLResourceRegistry();
+
+	void updateTotal(size_t oldBytes, size_t newBytes);
+
+	mutable std::mutex lock;
+	Category categories[RESOURCE_TYPE_COUNT];
+	size_t totalBytes, peakTotalBytes;
+	size_t budget;
+	bool overBudget;
+};
+
+// bytes of a 2d texture or renderbuffer with the given levels, for setBytes
+size_t textureBytes(GLenum internalFormat, int width, int height, int levels = 1);
+
+// levels in a full mip chain down to 1x1
+int mipLevels(int width, int height);
+
+// how each kind of object is made and destroyed, kind is the shader stage
+template <GLResourceType Type> struct GLResourceTraits;
+
+template <> struct GLResourceTraits<RESOURCE_BUFFER>
+{
+	static GLuint create(GLenum) { GLuint id = 0; glGenBuffers(1, &id); return id; }
+	static void destroy(GLuint id) { glDeleteBuffers(1, &id); }
+};
+
+template <> struct GLResourceTraits<RESOURCE_VERTEX_ARRAY>
+{
+	static GLuint create(GLenum) { GLuint id = 0; glGenVertexArrays(1, &id); return id; }
+	static void destroy(GLuint id) { glDeleteVertexArrays(1, &id); }
+};
+
+template <> struct GLResourceTraits<RESOURCE_TEXTURE>
+{
+	static GLuint create(GLenum) { GLuint id = 0; glGenTextures(1, &id); return id; }
+	static void destroy(GLuint id) { glDeleteTextures(1, &id); }
+};
+
+template <> struct GLResourceTraits<RESOURCE_RENDERBUFFER>
+{
+	static GLuint create(GLenum) { GLuint id = 0; glGenRenderbuffers(1, &id); return id; }
+	static void destroy(GLuint id) { glDeleteRenderbuffers(1, &id); }
+};
+
+template <> struct GLResourceTraits<RESOURCE_FRAMEBUFFER>
+{
+	static GLuint create(GLenum) { GLuint id = 0; glGenFramebuffers(1, &id); return id; }
+	static void destroy(GLuint id) { glDeleteFramebuffers(1, &id); }
+};
+
+template <> struct GLResourceTraits<RESOURCE_PROGRAM>
+{
+	static GLuint create(GLenum) { return glCreateProgram(); }
+	static void destroy(GLuint id) { glDeleteProgram(id); }
+};
+
+template <> struct GLResourceTraits<RESOURCE_SHADER>
+{
+	static GLuint create(GLenum stage) { return glCreateShader(stage); }
+	static void destroy(GLuint id) { glDeleteShader(id); }
+};
+
+template <> struct GLResourceTraits<RESOURCE_QUERY>
+{
+	static GLuint create(GLenum) { GLuint id = 0; glGenQueries(1, &id); return id; }
+	static void destroy(GLuint id) { glDeleteQueries(1, &id); }
+};
+
+// owns one gl object, move only. the object is deleted with the handle or on
+// reset(), which needs the owning (or a sharing) context to be current
+template <GLResourceType Type>
+class GLHandle
+{
+public:
+	GLHandle();
+	GLHandle(GLHandle &&other);
+	~GLHandle();
+
+	GLHandle &operator = (GLHandle &&other);
+
+	// replaces the object with a new one, kind is the stage for shaders
+	bool create(GLenum kind = 0);
+	void reset();
+
+	// memory held by the object, for the registry
+	void setBytes(size_t bytes);
+	size_t getBytes() const;
+
+	GLuint get() const;
+
+private:
+	GLHandle(const GLHandle &);
+	GLHandle &operator = (const GLHandle &);
+
+	GLuint id;
+	size_t bytes;
+};
+
+typedef GLHandle<RESOURCE_BUFFER> GLBuffer;
+typedef GLHandle<RESOURCE_VERTEX_ARRAY> GLVertexArray;
+typedef GLHandle<RESOURCE_TEXTURE> GLTexture;
+typedef GLHandle<RESOURCE_RENDERBUFFER> GLRenderbuffer;
+typedef GLHandle<RESOURCE_FRAMEBUFFER> GLFramebuffer;
+typedef GLHandle<RESOURCE_PROGRAM> GLProgram;
+typedef GLHandle<RESOURCE_SHADER> GLShaderObject;
+typedef GLHandle<RESOURCE_QUERY> GLQuery;
+
+template <GLResourceType Type>
+GLHandle<Type>::GLHandle() : id(0), bytes(0) {}
+
+template <GLResourceType Type>
+GLHandle<Type>::GLHandle(GLHandle &&other) : id(other.id), bytes(other.bytes)
+{
+	other.id = 0;
+	other.bytes = 0;
+}
+
+template <GLResourceType Type>
+GLHandle<Type>::~GLHandle()
+{
+	reset();
+}
+
+template <GLResourceType Type>
+GLHandle<Type> &GLHandle<Type>::operator = (GLHandle &&other)
+{
+	if (this != &other)
+	{
+		reset();
+		id = other.id;
+		bytes = other.bytes;
+		other.id = 0;
+		other.bytes = 0;
+	}
+
+	return *this;
+}
+
+template <GLResourceType Type>
+bool GLHandle<Type>::create(GLenum kind)
+{
+	reset();
+	if (!(id = GLResourceTraits<Type>::create(kind)))
+		return false;
+
+	GLResourceRegistry::getInstance().created(Type);
+	return true;
+}
+
+template <GLResourceType Type>
+void GLHandle<Type>::reset()
+{
+	if (!id)
+		return;
+
+	GLResourceTraits<Type>::destroy(id);
+	GLResourceRegistry::getInstance().destroyed(Type, bytes);
+	id = 0;
+	bytes = 0;
+}
+
+template <GLResourceType Type>
+void GLHandle<Type>::setBytes(size_t newBytes)
+{
+	GLResourceRegistry::getInstance().resized(Type, bytes, newBytes);
+	bytes = newBytes;
+}
+
+template <GLResourceType Type>
+size_t GLHandle<Type>::getBytes() const
+{
+	return bytes;
+}
+
+template <GLResourceType Type>
+GLuint GLHandle<Type>::get() const
+{
+	return id;
+}
+
+#endif
@@ -0,0 +1,96 @@
+#include "GpuTimer.h"
+
+GpuTimer::GpuTimer() : issued(0), retired(0), skipped(false) {}
+
+GpuTimer::~GpuTimer()
+{
+	release();
+}
+
+bool GpuTimer::init()
+{
+	for (int i = 0; i < GPUTIMER_QUERIES; ++i)
+		if (!queries[i].create())
+			return false;
+
+	return true;
+}
+
+void GpuTimer::release()
+{
+	for (int i = 0; i < GPUTIMER_QUERIES; ++i)
+		queries[i].reset();
+
+	issued = retired = 0;
+	skipped = false;
+}
+
+void GpuTimer::begin()
+{
+	// if the ring is full drop the oldest result, or when even that one isn't
+	// done skip timing this frame rather than waiting on it
+	if (issued - retired >= GPUTIMER_QUERIES)
+	{
+		GLint available = 0;
+		glGetQueryObjectiv(queries[retired % GPUTIMER_QUERIES].get(), GL_QUERY_RESULT_AVAILABLE, &available);
+		if (!available)
+		{
+			skipped = true;
+			return;
+		}
+
+		++retired;
+	}
+
+	glBeginQuery(GL_TIME_ELAPSED, queries[issued % GPUTIMER_QUERIES].get());
+}
+
+void GpuTimer::end()
+{
+	if (skipped)
+	{
+		skipped = false;
+		return;
+	}
+
+	glEndQuery(GL_TIME_ELAPSED);
+	++issued;
+}
+
+bool GpuTimer::poll(double &ms)
+{
+	bool found = false;
+
+	// drain everything that is ready and keep the newest
+	while (retired < issued)
+	{
+		const GLuint query = queries[retired % GPUTIMER_QUERIES].get();
+
+		GLint available = 0;
+		glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+		if (!available)
+			break;
+
+		GLuint64 elapsed;
+		glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed);
+		ms = elapsed / 1000000.0;
+		found = true;
+		++retired;
+	}
+
+	return found;
+}
+
+double GpuTimer::finish()
+{
+	double ms = 0.0;
+	while (retired < issued)
+	{
+		GLuint64 elapsed;
+		glGetQueryObjectui64v(queries[retired % GPUTIMER_QUERIES].get(), GL_QUERY_RESULT, &elapsed);
+		ms = elapsed / 1000000.0;
+		++retired;
+	}
+
+	return ms;
+}
@@ -0,0 +1,38 @@
+#ifndef GPUTIMER_H
+#define GPUTIMER_H
+
+#include <GL/glew.h>
+#include "GLResource.h"
+
+#define GPUTIMER_QUERIES 4
+
+// measures gpu time with GL_TIME_ELAPSED queries; results are read back a few
+// frames late so polling never stalls the pipeline
+class GpuTimer
+{
+public:
+	GpuTimer();
+	~GpuTimer();
+
+	bool init();
+	void release();
+
+	void begin();
+	void end();
+
+	// true if a new result was available, in milliseconds
+	bool poll(double &ms);
+
+	// blocks until the last query is done, for benchmarks
+	double finish();
+
+private:
+	GpuTimer(const GpuTimer &);
+	GpuTimer &operator = (const GpuTimer &);
+
+	GLQuery queries[GPUTIMER_QUERIES];
+	int issued, retired;
+	bool skipped;		// this frame isn't being timed, the ring was full
+};
+
+#endif
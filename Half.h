@@ -0,0 +1,101 @@
+#ifndef HALF_H
+#define HALF_H
+
+#include <string.h>
+
+// ieee 754 binary16, storage only. converts to and from float with round to
+// nearest even, like the gpu does for GL_HALF_FLOAT attributes
+class Half
+{
+public:
+	// trivial, so Vec2h and Vec3h stay trivially copyable
+	Half() = default;
+	Half(float value) : bits(fromFloat(value)) {}
+
+	operator float() const { return toFloat(bits); }
+
+	static unsigned short fromFloat(float value);
+	static float toFloat(unsigned short bits);
+
+	unsigned short bits;
+};
+
+inline unsigned short Half::fromFloat(float value)
+{
+	unsigned int f;
+	memcpy(&f, &value, sizeof(f));
+
+	const unsigned int sign = (f >> 16) & 0x8000;
+	const unsigned int exponent = (f >> 23) & 0xff;
+	unsigned int mantissa = f & 0x7fffff;
+
+	// inf and nan, nan keeps a mantissa bit so it stays nan
+	if (exponent == 0xff)
+		return (unsigned short)(sign | 0x7c00 | (mantissa ? 0x200 : 0));
+
+	const int halfExponent = (int)exponent - 127 + 15;
+
+	// too big, rounds to inf
+	if (halfExponent >= 31)
+		return (unsigned short)(sign | 0x7c00);
+
+	// subnormal or zero
+	if (halfExponent <= 0)
+	{
+		if (halfExponent < -10)
+			return (unsigned short)sign;
+
+		mantissa |= 0x800000;
+		const int shift = 14 - halfExponent;
+		unsigned int half = mantissa >> shift;
+		const unsigned int rest = mantissa & ((1u << shift) - 1), middle = 1u << (shift - 1);
+		if (rest > middle || (rest == middle && (half & 1)))
+			++half;
+
+		return (unsigned short)(sign | half);
+	}
+
+	// a carry out of the mantissa correctly bumps the exponent
+	unsigned int half = ((unsigned int)halfExponent << 10) | (mantissa >> 13);
+	const unsigned int rest = mantissa & 0x1fff;
+	if (rest > 0x1000 || (rest == 0x1000 && (half & 1)))
+		++half;
+
+	return (unsigned short)(sign | half);
+}
+
+inline float Half::toFloat(unsigned short bits)
+{
+	const unsigned int sign = (unsigned int)(bits & 0x8000) << 16;
+	unsigned int exponent = (bits >> 10) & 0x1f;
+	unsigned int mantissa = bits & 0x3ff;
+
+	unsigned int f;
+	if (exponent == 0x1f)
+		f = sign | 0x7f800000 | (mantissa << 13);
+	else if (exponent == 0)
+	{
+		if (mantissa == 0)
+			f = sign;
+		else
+		{
+			// normalize the subnormal
+			exponent = 127 - 15 + 1;
+			while (!(mantissa & 0x400))
+			{
+				mantissa <<= 1;
+				--exponent;
+			}
+
+			f = sign | (exponent << 23) | ((mantissa & 0x3ff) << 13);
+		}
+	}
+	else
+		f = sign | ((exponent - 15 + 127) << 23) | (mantissa << 13);
+
+	float value;
+	memcpy(&value, &f, sizeof(value));
+	return value;
+}
+
+#endif
@@ -0,0 +1,375 @@
+#include "JobSystem.h"
+
+#include <chrono>
+#include <stdio.h>
+
+#ifdef _MSC_VER
+#define JOB_THREAD_LOCAL __declspec(thread)
+#else
+#define JOB_THREAD_LOCAL __thread
+#endif
+
+// index of the calling thread, threads the pool doesn't know share deque 0
+static JOB_THREAD_LOCAL int threadIndex = -1;
+
+// jobs nest when one waits on another, busy time is only counted for the
+// innermost and not while a wait sleeps
+static JOB_THREAD_LOCAL int executeDepth = 0;
+static JOB_THREAD_LOCAL long long segmentStart = 0;
+
+Job::Job() : finished(false), dependencies(1), done(false) {}
+
+Job::Job(const std::function<void()> &work) : work(work), finished(false), dependencies(1), done(false) {}
+
+void Job::setWork(const std::function<void()> &jobWork)
+{
+	work = jobWork;
+}
+
+void Job::dependsOn(Job &other)
+{
+	std::lock_guard<std::mutex> guard(other.lock);
+	if (other.finished)
+		return;
+
+	++dependencies;
+	other.continuations.push_back(this);
+}
+
+bool Job::isDone() const
+{
+	return done.load();
+}
+
+JobSystem::JobSystem() : queued(0), sleeping(0), running(false), statsStart(0) {}
+
+JobSystem::~JobSystem()
+{
+	shutdown();
+}
+
+void JobSystem::init(int count)
+{
+	shutdown();
+
+	if (count <= 0)
+		count = (int)std::thread::hardware_concurrency();
+	if (count <= 0)
+		count = 1;
+	if (count > JOB_MAX_THREADS)
+		count = JOB_MAX_THREADS;
+
+	for (int i = 0; i < count; ++i)
+		workers.push_back(new Worker());
+
+	resetStats();
+	threadIndex = 0;
+	running = true;
+
+	for (int i = 1; i < count; ++i)
+		threads.push_back(std::thread(&JobSystem::loop, this, i));
+}
+
+void JobSystem::shutdown()
+{
+	if (running)
+	{
+		running = false;
+		{
+			std::lock_guard<std::mutex> guard(sleepLock);
+		}
+		sleepSignal.notify_all();
+	}
+
+	for (std::vector<std::thread>::iterator it = threads.begin(); it != threads.end(); ++it)
+		it->join();
+	threads.clear();
+
+	for (std::vector<Worker*>::iterator it = workers.begin(); it != workers.end(); ++it)
+		delete *it;
+	workers.clear();
+}
+
+// a job with unfinished dependencies is queued by the last one to finish
+void JobSystem::submit(Job &job)
+{
+	if (--job.dependencies == 0)
+		push(job);
+}
+
+// runs other jobs until this one is done and sleeps when there are none
+void JobSystem::wait(Job &job)
+{
+	const int thread = currentThread();
+
+	while (!job.isDone())
+	{
+		Job *next = take(thread);
+		if (next)
+		{
+			execute(*next, thread);
+			continue;
+		}
+
+		if (executeDepth > 0)
+			workers[thread]->busyNs += now() - segmentStart;
+
+		{
+			std::unique_lock<std::mutex> guard(sleepLock);
+			++sleeping;
+			while (!job.isDone() && queued.load() == 0)
+				sleepSignal.wait(guard);
+			--sleeping;
+		}
+
+		segmentStart = now();
+	}
+}
+
+void JobSystem::parallelFor(int begin, int end, int grain, const std::function<void(int, int)> &body)
+{
+	if (grain < 1)
+		grain = 1;
+
+	const int count = (end - begin + grain - 1) / grain;
+	if (count <= 1)
+	{
+		if (end > begin)
+			body(begin, end);
+		return;
+	}
+
+	// an empty job that finishes after every range has
+	Job join;
+	Job *ranges = new Job[count];
+
+	for (int i = 0; i < count; ++i)
+	{
+		const int first = begin + i * grain;
+		const int last = first + grain < end ? first + grain : end;
+
+		ranges[i].setWork([&body, first, last]() { body(first, last); });
+		join.dependsOn(ranges[i]);
+	}
+
+	// pushed in reverse, so this thread pops them in order and thieves take
+	// from the far end
+	for (int i = count - 1; i >= 0; --i)
+		submit(ranges[i]);
+
+	submit(join);
+	wait(join);
+
+	delete[] ranges;
+}
+
+int JobSystem::getThreadCount() const
+{
+	return (int)workers.size();
+}
+
+void JobSystem::resetStats()
+{
+	for (std::vector<Worker*>::iterator it = workers.begin(); it != workers.end(); ++it)
+	{
+		(*it)->executed = 0;
+		(*it)->steals = 0;
+		(*it)->busyNs = 0;
+	}
+
+	statsStart = now();
+}
+
+unsigned int JobSystem::getJobCount() const
+{
+	unsigned int count = 0;
+	for (std::vector<Worker*>::const_iterator it = workers.begin(); it != workers.end(); ++it)
+		count += (*it)->executed;
+
+	return count;
+}
+
+unsigned int JobSystem::getStealCount() const
+{
+	unsigned int count = 0;
+	for (std::vector<Worker*>::const_iterator it = workers.begin(); it != workers.end(); ++it)
+		count += (*it)->steals;
+
+	return count;
+}
+
+double JobSystem::getUtilization() const
+{
+	const long long elapsed = now() - statsStart;
+	if (elapsed <= 0 || workers.empty())
+		return 0.0;
+
+	long long busy = 0;
+	for (std::vector<Worker*>::const_iterator it = workers.begin(); it != workers.end(); ++it)
+		busy += (*it)->busyNs;
+
+	return (double)busy / ((double)elapsed * workers.size());
+}
+
+void JobSystem::report() const
+{
+	const double seconds = (now() - statsStart) / 1e9;
+
+	printf("Job system: %d threads, %u jobs, %u steals, %.1f%% utilization over %.2f s\n",
+		getThreadCount(), getJobCount(), getStealCount(), 100.0 * getUtilization(), seconds);
+
+	for (size_t i = 0; i < workers.size(); ++i)
+	{
+		const Worker &worker = *workers[i];
+		printf("  thread %-3d %8u jobs %8u steals %6.1f%% busy\n", (int)i, worker.executed.load(),
+			worker.steals.load(), seconds > 0.0 ? 100.0 * worker.busyNs / 1e9 / seconds : 0.0);
+	}
+}
+
+void JobSystem::loop(int thread)
+{
+	threadIndex = thread;
+
+	while (running)
+	{
+		Job *job = take(thread);
+		if (job)
+		{
+			execute(*job, thread);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> guard(sleepLock);
+		++sleeping;
+		while (running && queued.load() == 0)
+			sleepSignal.wait(guard);
+		--sleeping;
+	}
+}
+
+void JobSystem::push(Job &job)
+{
+	const int thread = currentThread();
+
+	// nothing to run it on, shouldn't happen outside of shutdown
+	if (workers.empty())
+	{
+		execute(job, 0);
+		return;
+	}
+
+	Worker &worker = *workers[thread];
+	{
+		std::lock_guard<std::mutex> guard(worker.lock);
+		worker.jobs.push_back(&job);
+	}
+
+	++queued;
+	wake(false);
+}
+
+// the back of our own deque, then the front of everyone else's
+Job *JobSystem::take(int thread)
+{
+	if (workers.empty() || queued.load() == 0)
+		return NULL;
+
+	const int count = (int)workers.size();
+	for (int i = 0; i < count; ++i)
+	{
+		Worker &victim = *workers[(thread + i) % count];
+
+		std::lock_guard<std::mutex> guard(victim.lock);
+		if (victim.jobs.empty())
+			continue;
+
+		Job *job;
+		if (i == 0)
+		{
+			job = victim.jobs.back();
+			victim.jobs.pop_back();
+		}
+		else
+		{
+			job = victim.jobs.front();
+			victim.jobs.pop_front();
+			++workers[thread]->steals;
+		}
+
+		--queued;
+		return job;
+	}
+
+	return NULL;
+}
+
+void JobSystem::execute(Job &job, int thread)
+{
+	const long long start = now();
+	if (executeDepth++ > 0 && !workers.empty())
+		workers[thread]->busyNs += start - segmentStart;
+	segmentStart = start;
+
+	if (job.work)
+		job.work();
+
+	const long long end = now();
+	if (!workers.empty())
+	{
+		Worker &worker = *workers[thread];
+		worker.busyNs += end - segmentStart;
+		++worker.executed;
+	}
+
+	// picks the outer job back up
+	--executeDepth;
+	segmentStart = end;
+
+	finish(job);
+}
+
+void JobSystem::finish(Job &job)
+{
+	std::vector<Job*> ready;
+	{
+		std::lock_guard<std::mutex> guard(job.lock);
+		job.finished = true;
+		ready.swap(job.continuations);
+	}
+
+	// whoever waits on the job may destroy it as soon as this is set, and
+	// once a continuation is queued so may whoever waits on that
+	job.done = true;
+
+	for (std::vector<Job*>::iterator it = ready.begin(); it != ready.end(); ++it)
+		submit(**it);
+
+	wake(true);
+}
+
+// the lock orders this against a sleeper that has just checked its condition.
+// any sleeper can take new work, but only the right one can use a finished job
+void JobSystem::wake(bool all)
+{
+	if (sleeping.load() == 0)
+		return;
+
+	{
+		std::lock_guard<std::mutex> guard(sleepLock);
+	}
+
+	if (all)
+		sleepSignal.notify_all();
+	else
+		sleepSignal.notify_one();
+}
+
+int JobSystem::currentThread()
+{
+	return threadIndex < 0 ? 0 : threadIndex;
+}
+
+long long JobSystem::now()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
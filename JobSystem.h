@@ -0,0 +1,110 @@
+#ifndef JOBSYSTEM_H
+#define JOBSYSTEM_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "Singleton.h"
+
+#define JOB_MAX_THREADS 64
+
+// a unit of work for the JobSystem. the caller owns it and has to keep it
+// alive until it is done, which wait() guarantees
+class Job
+{
+public:
+	Job();
+	explicit Job(const std::function<void()> &work);
+
+	void setWork(const std::function<void()> &work);
+
+	// this job won't start before other has finished. call it before this job
+	// is submitted, other may already be running
+	void dependsOn(Job &other);
+
+	bool isDone() const;
+
+private:
+	friend class JobSystem;
+
+	Job(const Job &);
+	Job &operator = (const Job &);
+
+	std::function<void()> work;
+	std::mutex lock;
+	std::vector<Job*> continuations;	// jobs waiting on this one
+	bool finished;						// under lock, continuations have been released
+	std::atomic<int> dependencies;		// unfinished jobs this one waits on, plus one until submitted
+	std::atomic<bool> done;				// the last thing written, the job may be destroyed after
+};
+
+// work stealing scheduler. every thread has its own deque, it pushes and pops
+// at the back and idle threads steal from the front of someone else's, so
+// the oldest and usually biggest pieces of work move. the thread that calls
+// init() is thread 0 and only runs jobs while it waits for one. threads with
+// nothing to do sleep, so does a wait() that can't help
+class JobSystem : public Singleton<JobSystem>
+{
+	friend class Singleton<JobSystem>;
+
+public:
+	~JobSystem();
+
+	// threads includes the calling one, 0 picks one per hardware thread
+	void init(int threads);
+	void shutdown();
+
+	void submit(Job &job);
+	void wait(Job &job);
+
+	// splits [begin, end) into grain sized ranges and returns once body ran
+	// over all of them, the calling thread helps
+	void parallelFor(int begin, int end, int grain, const std::function<void(int, int)> &body);
+
+	int getThreadCount() const;
+
+	// utilization is the share of wall time since the last reset that the
+	// threads spent running jobs
+	void resetStats();
+	unsigned int getJobCount() const;
+	unsigned int getStealCount() const;
+	double getUtilization() const;
+	void report() const;
+
+private:
+	struct Worker
+	{
+		std::mutex lock;
+		std::deque<Job*> jobs;
+		std::atomic<unsigned int> executed;
+		std::atomic<unsigned int> steals;
+		std::atomic<long long> busyNs;
+	};
+
+	JobSystem();
+
+	void loop(int thread);
+	void push(Job &job);
+	Job *take(int thread);
+	void execute(Job &job, int thread);
+	void finish(Job &job);
+	void wake(bool all);
+
+	static int currentThread();
+	static long long now();
+
+	std::vector<Worker*> workers;
+	std::vector<std::thread> threads;
+	std::atomic<int> queued;	// jobs sitting in any deque
+	std::atomic<int> sleeping;
+	std::atomic<bool> running;
+	std::mutex sleepLock;
+	std::condition_variable sleepSignal;
+	long long statsStart;
+};
+
+#endif
@@ -0,0 +1,115 @@
+#include "MappedFile.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+MappedFile::MappedFile() : file(INVALID_HANDLE_VALUE), mapping(NULL), data(NULL), size(0) {}
+
+bool MappedFile::open(const char *path)
+{
+	close();
+
+	file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+	{
+		close();
+		return false;
+	}
+
+	size = (size_t)fileSize.QuadPart;
+	if (!(mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL)) ||
+		!(data = (const unsigned char *)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0)))
+	{
+		close();
+		return false;
+	}
+
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (data)
+		UnmapViewOfFile(data);
+
+	if (mapping)
+		CloseHandle(mapping);
+
+	if (file != INVALID_HANDLE_VALUE)
+		CloseHandle(file);
+
+	file = INVALID_HANDLE_VALUE;
+	mapping = NULL;
+	data = NULL;
+	size = 0;
+}
+
+#else
+
+MappedFile::MappedFile() : file(-1), data(NULL), size(0) {}
+
+bool MappedFile::open(const char *path)
+{
+	close();
+
+	if ((file = ::open(path, O_RDONLY)) < 0)
+		return false;
+
+	struct stat info;
+	if (fstat(file, &info) != 0 || info.st_size == 0)
+	{
+		close();
+		return false;
+	}
+
+	size = (size_t)info.st_size;
+	void *view = mmap(NULL, size, PROT_READ, MAP_PRIVATE, file, 0);
+	if (view == MAP_FAILED)
+	{
+		close();
+		return false;
+	}
+
+	data = (const unsigned char *)view;
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (data)
+		munmap((void *)data, size);
+
+	if (file >= 0)
+		::close(file);
+
+	file = -1;
+	data = NULL;
+	size = 0;
+}
+
+#endif
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+const unsigned char *MappedFile::getData() const
+{
+	return data;
+}
+
+size_t MappedFile::getSize() const
+{
+	return size;
+}
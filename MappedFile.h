@@ -0,0 +1,44 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <stddef.h>
+
+#ifdef _WIN32
+// keeps winsock.h and the min/max macros out
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#endif
+
+// read only view of a whole file. pages come in when they are first touched,
+// so opening is cheap and the reads happen wherever the data is used
+class MappedFile
+{
+public:
+	MappedFile();
+	~MappedFile();
+
+	bool open(const char *path);
+	void close();
+
+	const unsigned char *getData() const;
+	size_t getSize() const;
+
+private:
+	MappedFile(const MappedFile &);
+	MappedFile &operator = (const MappedFile &);
+
+#ifdef _WIN32
+	HANDLE file, mapping;
+#else
+	int file;
+#endif
+	const unsigned char *data;
+	size_t size;
+};
+
+#endif
@@ -1,6 +1,8 @@
 #ifndef MAT4_H
 #define MAT4_H
 
+#include <limits>
+#include <type_traits>
 #include "Vec3.h"
 
 //column major 4x4 matrix
@@ -9,82 +11,80 @@ template <class T>
 class Mat4
 {
 public:
-	Mat4();
-	Mat4(const T *m);
+	Mat4() = default;
+	constexpr Mat4(const T *m);
 
-	Mat4<T> &operator = (const Mat4 &rhs);
-	Mat4<T> operator * (const Mat4 &rhs) const;
-	Mat4<T> transpose() const;
+	// in memory order, so one column after the other
+	constexpr Mat4(T m0, T m1, T m2, T m3,
+		T m4, T m5, T m6, T m7,
+		T m8, T m9, T m10, T m11,
+		T m12, T m13, T m14, T m15);
 
-	static Mat4<T> translate(const Vec3<T> &rhs);
-	static Mat4<T> perspective(T fovy, T aspect, T zNear, T zFar);
-	static Mat4<T> ortho(T left, T right, T bottom, T top, T zNear, T zFar);
-	static Mat4<T> identity();
+	constexpr Mat4<T> operator * (const Mat4 &rhs) const;
+	constexpr bool operator == (const Mat4 &rhs) const;
+	constexpr Mat4<T> transpose() const;
 
-	union
-	{
-		T mm[4][4];
-		T m[16];
-	};
+	static constexpr Mat4<T> translate(const Vec3<T> &rhs);
+	static constexpr Mat4<T> perspective(T fovy, T aspect, T zNear, T zFar);
+	static constexpr Mat4<T> ortho(T left, T right, T bottom, T top, T zNear, T zFar);
+	static constexpr Mat4<T> identity();
+
+	// element at column c, row r
+	constexpr T at(int c, int r) const;
+
+	T m[16];
 };
 
 typedef Mat4<float> Mat4f;
 
-template <class T>
-Mat4<T>::Mat4() {}
-
-template <class T>
-Mat4<T>::Mat4(const T *m)
+// tan for constant expressions, std::tan isn't constexpr. reduced to
+// [-pi/2, pi/2] where the sine and cosine series converge within 24 terms
+constexpr double constTan(double x)
 {
-	this->m[0] = m[0];
-	this->m[1] = m[1];
-	this->m[2] = m[2];
-	this->m[3] = m[3];
-
-	this->m[4] = m[4];
-	this->m[5] = m[5];
-	this->m[6] = m[6];
-	this->m[7] = m[7];
-
-	this->m[8] = m[8];
-	this->m[9] = m[9];
-	this->m[10] = m[10];
-	this->m[11] = m[11];
-
-	this->m[12] = m[12];
-	this->m[13] = m[13];
-	this->m[14] = m[14];
-	this->m[15] = m[15];
+	const double pi = 3.14159265358979323846;
+
+	x -= pi * (double)(long long)(x / pi);
+	if (x > pi * 0.5)
+		x -= pi;
+	else if (x < -pi * 0.5)
+		x += pi;
+
+	double sine = 0.0, cosine = 0.0, term = 1.0; // term is x^n / n!
+	for (int n = 0; n < 24; ++n)
+	{
+		switch (n % 4)
+		{
+		case 0: cosine += term; break;
+		case 1: sine += term; break;
+		case 2: cosine -= term; break;
+		case 3: sine -= term; break;
+		}
+
+		term *= x / (n + 1);
+	}
+
+	return sine / cosine;
 }
 
 template <class T>
-Mat4<T> &Mat4<T>::operator = (const Mat4 &rhs)
-{
-	m[0] = rhs.m[0];
-	m[1] = rhs.m[1];
-	m[2] = rhs.m[2];
-	m[3] = rhs.m[3];
-
-	m[4] = rhs.m[4];
-	m[5] = rhs.m[5];
-	m[6] = rhs.m[6];
-	m[7] = rhs.m[7];
-
-	m[8] = rhs.m[8];
-	m[9] = rhs.m[9];
-	m[10] = rhs.m[10];
-	m[11] = rhs.m[11];
-
-	m[12] = rhs.m[12];
-	m[13] = rhs.m[13];
-	m[14] = rhs.m[14];
-	m[15] = rhs.m[15];
-
-	return *this;
-}
+constexpr Mat4<T>::Mat4(const T *m)
+	: m{ m[0], m[1], m[2], m[3],
+	m[4], m[5], m[6], m[7],
+	m[8], m[9], m[10], m[11],
+	m[12], m[13], m[14], m[15] } {}
 
 template <class T>
-Mat4<T> Mat4<T>::operator * (const Mat4<T> &rhs) const
+constexpr Mat4<T>::Mat4(T m0, T m1, T m2, T m3,
+	T m4, T m5, T m6, T m7,
+	T m8, T m9, T m10, T m11,
+	T m12, T m13, T m14, T m15)
+	: m{ m0, m1, m2, m3,
+	m4, m5, m6, m7,
+	m8, m9, m10, m11,
+	m12, m13, m14, m15 } {}
+
+template <class T>
+constexpr Mat4<T> Mat4<T>::operator * (const Mat4<T> &rhs) const
 {
 	/*
 	0	4	8	12
@@ -92,135 +92,122 @@ Mat4<T> Mat4<T>::operator * (const Mat4<T> &rhs) const
 	2	6	10	14
 	3	7	11	15
 	*/
-	Mat4<T> mat;
-
-	mat.m[0] = m[0] * rhs.m[0] + m[4] * rhs.m[1] + m[8] * rhs.m[2] + m[12] * rhs.m[3];
-	mat.m[1] = m[1] * rhs.m[0] + m[5] * rhs.m[1] + m[9] * rhs.m[2] + m[13] * rhs.m[3];
-	mat.m[2] = m[2] * rhs.m[0] + m[6] * rhs.m[1] + m[10] * rhs.m[2] + m[14] * rhs.m[3];
-	mat.m[3] = m[3] * rhs.m[0] + m[7] * rhs.m[1] + m[11] * rhs.m[2] + m[15] * rhs.m[3];
-
-	mat.m[4] = m[0] * rhs.m[4] + m[4] * rhs.m[5] + m[8] * rhs.m[6] + m[12] * rhs.m[7];
-	mat.m[5] = m[1] * rhs.m[4] + m[5] * rhs.m[5] + m[9] * rhs.m[6] + m[13] * rhs.m[7];
-	mat.m[6] = m[2] * rhs.m[4] + m[6] * rhs.m[5] + m[10] * rhs.m[6] + m[14] * rhs.m[7];
-	mat.m[7] = m[3] * rhs.m[4] + m[7] * rhs.m[5] + m[11] * rhs.m[6] + m[15] * rhs.m[7];
-
-	mat.m[8] = m[0] * rhs.m[8] + m[4] * rhs.m[9] + m[8] * rhs.m[10] + m[12] * rhs.m[11];
-	mat.m[9] = m[1] * rhs.m[8] + m[5] * rhs.m[9] + m[9] * rhs.m[10] + m[13] * rhs.m[11];
-	mat.m[10] = m[2] * rhs.m[8] + m[6] * rhs.m[9] + m[10] * rhs.m[10] + m[14] * rhs.m[11];
-	mat.m[11] = m[3] * rhs.m[8] + m[7] * rhs.m[9] + m[11] * rhs.m[10] + m[15] * rhs.m[11];
-
-	mat.m[12] = m[0] * rhs.m[12] + m[4] * rhs.m[13] + m[8] * rhs.m[14] + m[12] * rhs.m[15];
-	mat.m[13] = m[1] * rhs.m[12] + m[5] * rhs.m[13] + m[9] * rhs.m[14] + m[13] * rhs.m[15];
-	mat.m[14] = m[2] * rhs.m[12] + m[6] * rhs.m[13] + m[10] * rhs.m[14] + m[14] * rhs.m[15];
-	mat.m[15] = m[3] * rhs.m[12] + m[7] * rhs.m[13] + m[11] * rhs.m[14] + m[15] * rhs.m[15];
-
-	return mat;
+	return Mat4<T>(
+		m[0] * rhs.m[0] + m[4] * rhs.m[1] + m[8] * rhs.m[2] + m[12] * rhs.m[3],
+		m[1] * rhs.m[0] + m[5] * rhs.m[1] + m[9] * rhs.m[2] + m[13] * rhs.m[3],
+		m[2] * rhs.m[0] + m[6] * rhs.m[1] + m[10] * rhs.m[2] + m[14] * rhs.m[3],
+		m[3] * rhs.m[0] + m[7] * rhs.m[1] + m[11] * rhs.m[2] + m[15] * rhs.m[3],
+
+		m[0] * rhs.m[4] + m[4] * rhs.m[5] + m[8] * rhs.m[6] + m[12] * rhs.m[7],
+		m[1] * rhs.m[4] + m[5] * rhs.m[5] + m[9] * rhs.m[6] + m[13] * rhs.m[7],
+		m[2] * rhs.m[4] + m[6] * rhs.m[5] + m[10] * rhs.m[6] + m[14] * rhs.m[7],
+		m[3] * rhs.m[4] + m[7] * rhs.m[5] + m[11] * rhs.m[6] + m[15] * rhs.m[7],
+
+		m[0] * rhs.m[8] + m[4] * rhs.m[9] + m[8] * rhs.m[10] + m[12] * rhs.m[11],
+		m[1] * rhs.m[8] + m[5] * rhs.m[9] + m[9] * rhs.m[10] + m[13] * rhs.m[11],
+		m[2] * rhs.m[8] + m[6] * rhs.m[9] + m[10] * rhs.m[10] + m[14] * rhs.m[11],
+		m[3] * rhs.m[8] + m[7] * rhs.m[9] + m[11] * rhs.m[10] + m[15] * rhs.m[11],
+
+		m[0] * rhs.m[12] + m[4] * rhs.m[13] + m[8] * rhs.m[14] + m[12] * rhs.m[15],
+		m[1] * rhs.m[12] + m[5] * rhs.m[13] + m[9] * rhs.m[14] + m[13] * rhs.m[15],
+		m[2] * rhs.m[12] + m[6] * rhs.m[13] + m[10] * rhs.m[14] + m[14] * rhs.m[15],
+		m[3] * rhs.m[12] + m[7] * rhs.m[13] + m[11] * rhs.m[14] + m[15] * rhs.m[15]);
 }
 
 template <class T>
-Mat4<T> Mat4<T>::transpose() const
+constexpr bool Mat4<T>::operator == (const Mat4<T> &rhs) const
 {
-	Mat4<T> mat;
+	for (int i = 0; i < 16; ++i)
+		if (m[i] != rhs.m[i])
+			return false;
 
-	mat.m[0] = m[0];
-	mat.m[1] = m[4];
-	mat.m[2] = m[8];
-	mat.m[3] = m[12];
-
-	mat.m[4] = m[1];
-	mat.m[5] = m[5];
-	mat.m[6] = m[9];
-	mat.m[7] = m[13];
-
-	mat.m[8] = m[2];
-	mat.m[9] = m[6];
-	mat.m[10] = m[10];
-	mat.m[11] = m[14];
-
-	mat.m[12] = m[3];
-	mat.m[13] = m[7];
-	mat.m[14] = m[11];
-	mat.m[15] = m[15];
-
-	return mat;
+	return true;
 }
 
 template <class T>
-Mat4<T> Mat4<T>::translate(const Vec3<T> &rhs)
+constexpr Mat4<T> Mat4<T>::transpose() const
 {
-	Mat4<T> mat = Mat4<T>::identity();
-
-	mat.m[12] = rhs.x;
-	mat.m[13] = rhs.y;
-	mat.m[14] = rhs.z;
+	return Mat4<T>(
+		m[0], m[4], m[8], m[12],
+		m[1], m[5], m[9], m[13],
+		m[2], m[6], m[10], m[14],
+		m[3], m[7], m[11], m[15]);
+}
 
-	return mat;
+template <class T>
+constexpr Mat4<T> Mat4<T>::translate(const Vec3<T> &rhs)
+{
+	return Mat4<T>(
+		1.0f, 0.0f, 0.0f, 0.0f,
+		0.0f, 1.0f, 0.0f, 0.0f,
+		0.0f, 0.0f, 1.0f, 0.0f,
+		rhs.x, rhs.y, rhs.z, 1.0f);
 }
 
 // for setting up a perspective matrix
 template <class T>
-Mat4<T> Mat4<T>::perspective(T fovy, T aspect, T zNear, T zFar)
+constexpr Mat4<T> Mat4<T>::perspective(T fovy, T aspect, T zNear, T zFar)
 {
 	if (aspect <= 0.0f)
 		aspect = std::numeric_limits<T>::epsilon();
 
-	const T tanHalfFovy = tan(fovy * 0.5f);
-
-	Mat4<T> mat = Mat4<T>::identity();
-	mat.mm[0][0] = 1.0f / (aspect * tanHalfFovy);
-	mat.mm[1][1] = 1.0f / (tanHalfFovy);
-	mat.mm[2][2] = -(zFar + zNear) / (zFar - zNear);
-	mat.mm[2][3] = -1.0f;
-	mat.mm[3][2] = -(2.0f * zFar * zNear) / (zFar - zNear);
+	const T tanHalfFovy = (T)constTan(fovy * 0.5f);
 
-	return mat;
+	return Mat4<T>(
+		1.0f / (aspect * tanHalfFovy), 0.0f, 0.0f, 0.0f,
+		0.0f, 1.0f / (tanHalfFovy), 0.0f, 0.0f,
+		0.0f, 0.0f, -(zFar + zNear) / (zFar - zNear), -1.0f,
+		0.0f, 0.0f, -(2.0f * zFar * zNear) / (zFar - zNear), 1.0f);
 }
 
 // ortho matrix creation
 template <class T>
-Mat4<T>  Mat4<T>::ortho(T left, T right, T bottom, T top, T zNear, T zFar)
+constexpr Mat4<T> Mat4<T>::ortho(T left, T right, T bottom, T top, T zNear, T zFar)
 {
-	Mat4<T> mat = Mat4<T>::identity();
-
 	const T width = right - left;
 	const T height = top - bottom;
 	const T length = zFar - zNear;
 
-	mat.mm[0][0] = 2.0f / width;
-	mat.mm[1][1] = 2.0f / height;
-	mat.mm[2][2] = -2.0f / length;
-	mat.mm[3][0] = -(right + left) / width;
-	mat.mm[3][1] = -(top + bottom) / height;
-	mat.mm[3][2] = -(zFar + zNear) / length;
-
-	return mat;
+	return Mat4<T>(
+		2.0f / width, 0.0f, 0.0f, 0.0f,
+		0.0f, 2.0f / height, 0.0f, 0.0f,
+		0.0f, 0.0f, -2.0f / length, 0.0f,
+		-(right + left) / width, -(top + bottom) / height, -(zFar + zNear) / length, 1.0f);
 }
 
 template <class T>
-Mat4<T> Mat4<T>::identity()
+constexpr Mat4<T> Mat4<T>::identity()
 {
-	Mat4<T> mat;
-
-	mat.m[0] = 1.0f;
-	mat.m[1] = 0.0f;
-	mat.m[2] = 0.0f;
-	mat.m[3] = 0.0f;
-
-	mat.m[4] = 0.0f;
-	mat.m[5] = 1.0f;
-	mat.m[6] = 0.0f;
-	mat.m[7] = 0.0f;
+	return Mat4<T>(
+		1.0f, 0.0f, 0.0f, 0.0f,
+		0.0f, 1.0f, 0.0f, 0.0f,
+		0.0f, 0.0f, 1.0f, 0.0f,
+		0.0f, 0.0f, 0.0f, 1.0f);
+}
 
-	mat.m[8] = 0.0f;
-	mat.m[9] = 0.0f;
-	mat.m[10] = 1.0f;
-	mat.m[11] = 0.0f;
+template <class T>
+constexpr T Mat4<T>::at(int c, int r) const
+{
+	return m[c * 4 + r];
+}
 
-	mat.m[12] = 0.0f;
-	mat.m[13] = 0.0f;
-	mat.m[14] = 0.0f;
-	mat.m[15] = 1.0f;
+// the projection of the fullscreen quad over [0, 1], folded at compile time
+constexpr Mat4f QUAD_PROJECTION = Mat4f::ortho(0.0f, 1.0f, 0.0f, 1.0f, -1.0f, 1.0f);
+
+static_assert(std::is_trivially_copyable<Mat4f>::value, "Mat4f must be trivially copyable");
+static_assert(sizeof(Mat4f) == 16 * sizeof(float), "Mat4f must be tightly packed");
+static_assert(QUAD_PROJECTION == Mat4f(
+	2.0f, 0.0f, 0.0f, 0.0f,
+	0.0f, 2.0f, 0.0f, 0.0f,
+	0.0f, 0.0f, -1.0f, 0.0f,
+	-1.0f, -1.0f, 0.0f, 1.0f), "QUAD_PROJECTION must map [0, 1] to clip space");
+static_assert(Mat4f::identity() * QUAD_PROJECTION == QUAD_PROJECTION, "identity must be neutral");
+static_assert((Mat4f::translate(Vec3f(1.0f, 2.0f, 3.0f)) * Mat4f::translate(Vec3f(-1.0f, -2.0f, -3.0f))) == Mat4f::identity(),
+	"translations must cancel");
+static_assert(Mat4f::translate(Vec3f(1.0f, 2.0f, 3.0f)).transpose().at(0, 3) == 1.0f, "transpose must swap rows and columns");
+static_assert(Mat4f::perspective(1.5707963f, 1.0f, 1.0f, 3.0f).at(2, 2) == -2.0f &&
+	Mat4f::perspective(1.5707963f, 1.0f, 1.0f, 3.0f).at(3, 2) == -3.0f &&
+	Mat4f::perspective(1.5707963f, 1.0f, 1.0f, 3.0f).at(0, 0) > 0.9999f &&
+	Mat4f::perspective(1.5707963f, 1.0f, 1.0f, 3.0f).at(0, 0) < 1.0001f, "perspective must be constexpr");
 
-	return mat;
-}
 #endif
\ No newline at end of file
@@ -0,0 +1,93 @@
+#include "Mesh.h"
+
+#include <stdio.h>
+
+Mesh::Mesh()
+	: indexType(GL_UNSIGNED_INT), indexCount(0), setup(NULL) {}
+
+Mesh::~Mesh()
+{
+	release();
+}
+
+void Mesh::release()
+{
+	vertexBuffer.reset();
+	indexBuffer.reset();
+	vertexArray.reset();
+	indexCount = 0;
+}
+
+void Mesh::draw() const
+{
+	draw(vertexArray);
+}
+
+bool Mesh::createVertexArray(GLVertexArray &array) const
+{
+	if (!setup || !array.create())
+		return false;
+
+	glBindVertexArray(array.get());
+	glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer.get());
+	setup();
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer.get());
+	glBindVertexArray(0);
+
+	return glGetError() == GL_NO_ERROR;
+}
+
+void Mesh::draw(const GLVertexArray &array) const
+{
+	glBindVertexArray(array.get());
+	glDrawElements(GL_TRIANGLES, indexCount, indexType, 0);
+}
+
+GLenum Mesh::getIndexType() const
+{
+	return indexType;
+}
+
+GLsizei Mesh::getIndexCount() const
+{
+	return indexCount;
+}
+
+size_t Mesh::getVertexBytes() const
+{
+	return vertexBuffer.getBytes();
+}
+
+size_t Mesh::getIndexBytes() const
+{
+	return indexBuffer.getBytes();
+}
+
+// the vertex array has to be bound, it keeps the element buffer
+bool Mesh::uploadIndices(const std::vector<GLuint> &indices, size_t vertexCount, bool narrowIndices)
+{
+	indexType = narrowIndices ? indexTypeFor(vertexCount) : GL_UNSIGNED_INT;
+	indexCount = (GLsizei)indices.size();
+	const size_t indexBytes = indices.size() * indexSize(indexType);
+
+	indexBuffer.create();
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer.get());
+
+	if (indexType == GL_UNSIGNED_INT)
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexBytes, &indices.front(), GL_STATIC_DRAW);
+	else
+	{
+		std::vector<GLushort> narrow(indices.begin(), indices.end());
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexBytes, &narrow.front(), GL_STATIC_DRAW);
+	}
+
+	indexBuffer.setBytes(indexBytes);
+
+	if (glGetError() != GL_NO_ERROR)
+	{
+		printf("Failed to upload mesh!\n");
+		return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,71 @@
+#ifndef MESH_H
+#define MESH_H
+
+#include <GL/glew.h>
+#include <vector>
+#include "GLResource.h"
+#include "VertexFormat.h"
+
+// static indexed triangle mesh in one interleaved vertex buffer. the vertex
+// array keeps the attribute setup, so drawing is a bind and a draw call
+class Mesh
+{
+public:
+	Mesh();
+	~Mesh();
+
+	// indices get the narrowest type that fits unless narrowIndices is false
+	template <class Layout>
+	bool upload(const std::vector<typename Layout::Vertex> &vertices, const std::vector<GLuint> &indices, bool narrowIndices = true);
+	void release();
+
+	void draw() const;
+
+	// vertex arrays aren't shared between contexts, this builds one over the
+	// same buffers for a context sharing with the one that uploaded the mesh
+	bool createVertexArray(GLVertexArray &array) const;
+	void draw(const GLVertexArray &array) const;
+
+	GLenum getIndexType() const;
+	GLsizei getIndexCount() const;
+	size_t getVertexBytes() const;
+	size_t getIndexBytes() const;
+
+private:
+	Mesh(const Mesh &);
+	Mesh &operator = (const Mesh &);
+
+	bool uploadIndices(const std::vector<GLuint> &indices, size_t vertexCount, bool narrowIndices);
+
+	GLVertexArray vertexArray;
+	GLBuffer vertexBuffer, indexBuffer;
+	GLenum indexType;
+	GLsizei indexCount;
+	void (*setup)();
+};
+
+template <class Layout>
+bool Mesh::upload(const std::vector<typename Layout::Vertex> &vertices, const std::vector<GLuint> &indices, bool narrowIndices)
+{
+	release();
+	if (vertices.empty() || indices.empty())
+		return false;
+
+	vertexArray.create();
+	glBindVertexArray(vertexArray.get());
+
+	const size_t vertexBytes = vertices.size() * Layout::stride;
+	vertexBuffer.create();
+	glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer.get());
+	glBufferData(GL_ARRAY_BUFFER, vertexBytes, &vertices.front(), GL_STATIC_DRAW);
+	vertexBuffer.setBytes(vertexBytes);
+
+	setup = &Layout::setup;
+	setup();
+
+	const bool success = uploadIndices(indices, vertices.size(), narrowIndices);
+	glBindVertexArray(0);
+	return success;
+}
+
+#endif
@@ -0,0 +1,134 @@
+#include "Process.h"
+
+#ifndef _WIN32
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+Process::Process() : handle(NULL) {}
+
+Process::~Process()
+{
+	if (handle)
+		CloseHandle(handle);
+}
+
+bool Process::spawn(const std::vector<std::string> &args)
+{
+	// quote every argument, none of ours contain quotes
+	std::string commandLine;
+	for (std::vector<std::string>::const_iterator it = args.begin(); it != args.end(); ++it)
+	{
+		if (!commandLine.empty())
+			commandLine += ' ';
+		commandLine += '"' + *it + '"';
+	}
+
+	STARTUPINFOA startup;
+	PROCESS_INFORMATION info;
+	ZeroMemory(&startup, sizeof(startup));
+	startup.cb = sizeof(startup);
+
+	std::vector<char> buffer(commandLine.begin(), commandLine.end());
+	buffer.push_back('\0');
+
+	if (!CreateProcessA(args[0].c_str(), &buffer[0], NULL, NULL, FALSE, 0, NULL, NULL, &startup, &info))
+		return false;
+
+	CloseHandle(info.hThread);
+	handle = info.hProcess;
+	return true;
+}
+
+void Process::kill()
+{
+	if (handle)
+		TerminateProcess(handle, 1);
+}
+
+bool Process::wait()
+{
+	if (!handle)
+		return false;
+
+	DWORD code = 1;
+	WaitForSingleObject(handle, INFINITE);
+	GetExitCodeProcess(handle, &code);
+	CloseHandle(handle);
+	handle = NULL;
+	return code == 0;
+}
+
+bool Process::isRunning() const
+{
+	return handle && WaitForSingleObject(handle, 0) == WAIT_TIMEOUT;
+}
+
+std::string Process::executablePath(const char *argv0)
+{
+	char path[MAX_PATH];
+	const DWORD length = GetModuleFileNameA(NULL, path, MAX_PATH);
+	return length > 0 && length < MAX_PATH ? std::string(path, length) : std::string(argv0);
+}
+
+#else
+
+Process::Process() : pid(-1) {}
+
+Process::~Process()
+{
+	// reap so we don't leave zombies behind
+	if (pid > 0)
+		waitpid(pid, NULL, WNOHANG);
+}
+
+bool Process::spawn(const std::vector<std::string> &args)
+{
+	std::vector<char*> argv;
+	for (std::vector<std::string>::const_iterator it = args.begin(); it != args.end(); ++it)
+		argv.push_back(const_cast<char*>(it->c_str()));
+	argv.push_back(NULL);
+
+	pid = fork();
+	if (pid == 0)
+	{
+		execv(argv[0], &argv[0]);
+		_exit(127);
+	}
+
+	return pid > 0;
+}
+
+void Process::kill()
+{
+	if (pid > 0)
+		::kill(pid, SIGKILL);
+}
+
+bool Process::wait()
+{
+	if (pid <= 0)
+		return false;
+
+	int status = 0;
+	waitpid(pid, &status, 0);
+	pid = -1;
+	return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+bool Process::isRunning() const
+{
+	return pid > 0 && ::kill(pid, 0) == 0;
+}
+
+std::string Process::executablePath(const char *argv0)
+{
+	char path[4096];
+	const ssize_t length = readlink("/proc/self/exe", path, sizeof(path));
+	return length > 0 && length < (ssize_t)sizeof(path) ? std::string(path, length) : std::string(argv0);
+}
+
+#endif
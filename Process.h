@@ -0,0 +1,49 @@
+#ifndef PROCESS_H
+#define PROCESS_H
+
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+// keeps winsock.h and the min/max macros out
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <sys/types.h>
+#endif
+
+// child process handle, used to launch local render farm workers
+class Process
+{
+public:
+	Process();
+	~Process();
+
+	// args[0] is the executable
+	bool spawn(const std::vector<std::string> &args);
+	void kill();
+	// blocks until the process exits, returns false if it failed
+	bool wait();
+
+	bool isRunning() const;
+
+	// full path of the running executable, argv0 is the fallback
+	static std::string executablePath(const char *argv0);
+
+private:
+	Process(const Process &);
+	Process &operator = (const Process &);
+
+#ifdef _WIN32
+	HANDLE handle;
+#else
+	pid_t pid;
+#endif
+};
+
+#endif
@@ -0,0 +1,336 @@
+#include "ProgressiveRenderer.h"
+#include "Mat4.h"
+
+#include <GLFW/glfw3.h>
+#include <stdio.h>
+#include <vector>
+
+// same pattern as sampleOffset in basic.frag, sample 0 is the pixel centre
+static float halton(int i, int base)
+{
+	float f = 1.0f;
+	float r = 0.0f;
+
+	while (i > 0)
+	{
+		f /= base;
+		r += f * (i % base);
+		i /= base;
+	}
+
+	return r;
+}
+
+ProgressiveRenderer::ProgressiveRenderer()
+	: scene(NULL), noiseShader(NULL), previewShader(NULL), width(0), height(0), tilesX(0), tilesY(0),
+	targetSamples(64), targetNoise(0.0f), frameBudget(50.0f),
+	samples(0), tile(0), tilesPerFrame(1), tilesThisFrame(0), noise(-1.0f),
+	startTime(0.0), frameStart(0.0), worstFrame(0.0), frames(0) {}
+
+ProgressiveRenderer::~ProgressiveRenderer()
+{
+	release();
+}
+
+static void createTarget(GLTexture &texture, GLint internalFormat, GLenum format, int width, int height)
+{
+	texture.create();
+	glBindTexture(GL_TEXTURE_2D, texture.get());
+	glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, GL_FLOAT, NULL);
+	texture.setBytes(textureBytes(internalFormat, width, height));
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+}
+
+bool ProgressiveRenderer::init(ShaderCache &cache, Shader *scene, int width, int height)
+{
+	GLint maxSize;
+	glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+	if (width <= 0 || height <= 0 || width > maxSize || height > maxSize)
+	{
+		printf("Progressive target %dx%d is outside 1-%d!\n", width, height, maxSize);
+		return false;
+	}
+
+	if ((this->scene = scene)->getUniformLocation("u_Jitter") == -1)
+	{
+		printf("Failed to locate u_Jitter!\n");
+		return false;
+	}
+
+	noiseShader = cache.get("basic.vert", "noise.frag");
+	previewShader = cache.get("basic.vert", "resolve.frag");
+	if (!noiseShader || !previewShader)
+	{
+		printf("Failed to link progressive shaders!\n");
+		return false;
+	}
+
+	noiseShader->getUniformLocation("u_ModelViewProjectionMatrix");
+	noiseShader->getUniformLocation("u_Accumulation");
+	noiseShader->getUniformLocation("u_Moments");
+	previewShader->getUniformLocation("u_ModelViewProjectionMatrix");
+	previewShader->getUniformLocation("u_Accumulation");
+
+	release();
+	this->width = width;
+	this->height = height;
+	tilesX = (width + PROGRESSIVE_TILE_SIZE - 1) / PROGRESSIVE_TILE_SIZE;
+	tilesY = (height + PROGRESSIVE_TILE_SIZE - 1) / PROGRESSIVE_TILE_SIZE;
+
+	// colour sum with the sample count in alpha, and luminance moments
+	createTarget(accumulation, GL_RGBA32F, GL_RGBA, width, height);
+	createTarget(moments, GL_RG32F, GL_RG, width, height);
+
+	fbo.create();
+	glBindFramebuffer(GL_FRAMEBUFFER, fbo.get());
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, accumulation.get(), 0);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, moments.get(), 0);
+
+	const bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+
+	glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+	static const GLenum buffers[] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+	glDrawBuffers(2, buffers);
+	glClear(GL_COLOR_BUFFER_BIT);
+
+	// per pixel standard error, mipmapped down to a single average
+	createTarget(noiseTexture, GL_R16F, GL_RED, width, height);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_NEAREST);
+	glGenerateMipmap(GL_TEXTURE_2D);
+	noiseTexture.setBytes(textureBytes(GL_R16F, width, height, mipLevels(width, height)));
+
+	noiseFbo.create();
+	glBindFramebuffer(GL_FRAMEBUFFER, noiseFbo.get());
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, noiseTexture.get(), 0);
+
+	const bool noiseComplete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	if (!complete || !noiseComplete)
+	{
+		printf("Progressive framebuffer is incomplete!\n");
+		return false;
+	}
+
+	samples = tile = tilesThisFrame = frames = 0;
+	tilesPerFrame = 1;
+	noise = -1.0f;
+	worstFrame = 0.0;
+	startTime = glfwGetTime();
+
+	printf("Progressive render: %dx%d in %dx%d tiles\n", width, height, tilesX, tilesY);
+	return true;
+}
+
+void ProgressiveRenderer::release()
+{
+	fbo.reset();
+	noiseFbo.reset();
+	accumulation.reset();
+	moments.reset();
+	noiseTexture.reset();
+}
+
+void ProgressiveRenderer::setTarget(int samples, float noise)
+{
+	targetSamples = samples;
+	targetNoise = noise;
+}
+
+void ProgressiveRenderer::setFrameBudget(float ms) { frameBudget = ms; }
+
+void ProgressiveRenderer::beginFrame()
+{
+	static const GLenum buffers[] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+
+	glBindFramebuffer(GL_FRAMEBUFFER, fbo.get());
+	glDrawBuffers(2, buffers);
+	glViewport(0, 0, width, height);
+
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_ONE, GL_ONE);
+	glEnable(GL_SCISSOR_TEST);
+
+	// every tile of a pass shares the jitter
+	scene->bind();
+	scene->setUniform2f("u_Jitter",
+		samples == 0 ? 0.0f : halton(samples, 2) - 0.5f,
+		samples == 0 ? 0.0f : halton(samples, 3) - 0.5f);
+
+	tilesThisFrame = 0;
+	frameStart = glfwGetTime();
+}
+
+// scissors the next tile, false once the frame's share is issued or the pass is complete
+bool ProgressiveRenderer::nextTile()
+{
+	if (tilesThisFrame >= tilesPerFrame || tile >= tilesX * tilesY)
+		return false;
+
+	const int x = (tile % tilesX) * PROGRESSIVE_TILE_SIZE;
+	const int y = (tile / tilesX) * PROGRESSIVE_TILE_SIZE;
+	glScissor(x, y, PROGRESSIVE_TILE_SIZE, PROGRESSIVE_TILE_SIZE);
+
+	++tile;
+	++tilesThisFrame;
+	return true;
+}
+
+// returns true when a pass over the whole image completed this frame
+bool ProgressiveRenderer::endFrame()
+{
+	glDisable(GL_SCISSOR_TEST);
+	glDisable(GL_BLEND);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	// the wait is what keeps each frame's work bounded
+	glFinish();
+	const double ms = (glfwGetTime() - frameStart) * 1000.0;
+	if (ms > worstFrame)
+		worstFrame = ms;
+	++frames;
+
+	// scale the tile count towards the budget, at most doubling per frame
+	int next = (int)(tilesThisFrame * frameBudget / (ms > 0.01 ? ms : 0.01));
+	if (next > tilesThisFrame * 2)
+		next = tilesThisFrame * 2;
+	if (tilesThisFrame == tilesPerFrame || next < tilesPerFrame)
+		tilesPerFrame = next < 1 ? 1 : (next > tilesX * tilesY ? tilesX * tilesY : next);
+
+	if (tile < tilesX * tilesY)
+		return false;
+
+	tile = 0;
+	++samples;
+	return targetNoise > 0.0f && samples >= PROGRESSIVE_NOISE_MIN_SAMPLES;
+}
+
+void ProgressiveRenderer::beginNoise()
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, noiseFbo.get());
+	glViewport(0, 0, width, height);
+
+	noiseShader->bind();
+	noiseShader->setUniformMatrix4fv("u_ModelViewProjectionMatrix", 1, GL_FALSE, QUAD_PROJECTION.m);
+	noiseShader->setUniform1i("u_Accumulation", 0);
+	noiseShader->setUniform1i("u_Moments", 1);
+
+	glActiveTexture(GL_TEXTURE1);
+	glBindTexture(GL_TEXTURE_2D, moments.get());
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, accumulation.get());
+}
+
+// average standard error of the pixel luminance
+float ProgressiveRenderer::endNoise()
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glActiveTexture(GL_TEXTURE1);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glActiveTexture(GL_TEXTURE0);
+
+	glBindTexture(GL_TEXTURE_2D, noiseTexture.get());
+	glGenerateMipmap(GL_TEXTURE_2D);
+
+	int level = 0;
+	for (int size = width > height ? width : height; size > 1; size /= 2)
+		++level;
+
+	glGetTexImage(GL_TEXTURE_2D, level, GL_RED, GL_FLOAT, &noise);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	return noise;
+}
+
+void ProgressiveRenderer::beginPreview(int width, int height)
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glViewport(0, 0, width, height);
+
+	previewShader->bind();
+	previewShader->setUniformMatrix4fv("u_ModelViewProjectionMatrix", 1, GL_FALSE, QUAD_PROJECTION.m);
+	previewShader->setUniform1i("u_Accumulation", 0);
+
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, accumulation.get());
+}
+
+bool ProgressiveRenderer::isDone() const
+{
+	return samples >= targetSamples || (noise >= 0.0f && noise <= targetNoise);
+}
+
+// writes a binary ppm, reading the target back a strip at a time so an 8k
+// float image never has to fit in memory at once
+bool ProgressiveRenderer::save(const char *path) const
+{
+	FILE *file = fopen(path, "wb");
+	if (!file)
+	{
+		printf("Failed to open %s!\n", path);
+		return false;
+	}
+
+	fprintf(file, "P6\n%d %d\n255\n", width, height);
+
+	const int rows = PROGRESSIVE_TILE_SIZE;
+	std::vector<float> strip(width * rows * 4);
+	std::vector<unsigned char> line(width * 3);
+
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo.get());
+	glReadBuffer(GL_COLOR_ATTACHMENT0);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+
+	// ppm rows go top down, gl rows bottom up
+	for (int top = height; top > 0; top -= rows)
+	{
+		const int count = top < rows ? top : rows;
+		glReadPixels(0, top - count, width, count, GL_RGBA, GL_FLOAT, &strip[0]);
+
+		for (int y = count - 1; y >= 0; --y)
+		{
+			const float *pixel = &strip[y * width * 4];
+			for (int x = 0; x < width; ++x, pixel += 4)
+			{
+				const float weight = pixel[3] > 1.0f ? 1.0f / pixel[3] : 1.0f;
+				for (int c = 0; c < 3; ++c)
+				{
+					const float value = pixel[c] * weight;
+					line[x * 3 + c] = (unsigned char)(value >= 1.0f ? 255 : (value <= 0.0f ? 0 : value * 255.0f + 0.5f));
+				}
+			}
+
+			fwrite(&line[0], 1, line.size(), file);
+		}
+	}
+
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+	fclose(file);
+
+	printf("Saved %s\n", path);
+	return true;
+}
+
+void ProgressiveRenderer::report() const
+{
+	const double seconds = glfwGetTime() - startTime;
+	const double pixelSamples = (double)width * height * samples;
+
+	printf("Progressive: %dx%d, %d samples in %.2f s over %d frames\n", width, height, samples, seconds, frames);
+	printf("  %.2f Msamples/s, %.2f ms/frame average, %.2f ms worst, %d tiles/frame", pixelSamples / seconds / 1000000.0,
+		frames ? seconds * 1000.0 / frames : 0.0, worstFrame, tilesPerFrame);
+
+	if (noise >= 0.0f)
+		printf(", noise %.5f", noise);
+
+	printf("\n");
+}
+
+int ProgressiveRenderer::getWidth() const { return width; }
+
+int ProgressiveRenderer::getHeight() const { return height; }
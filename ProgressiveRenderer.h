@@ -0,0 +1,75 @@
+#ifndef PROGRESSIVERENDERER_H
+#define PROGRESSIVERENDERER_H
+
+#include <GL/glew.h>
+#include "GLResource.h"
+#include "Shader.h"
+#include "ShaderCache.h"
+
+#define PROGRESSIVE_TILE_SIZE 256
+#define PROGRESSIVE_NOISE_MIN_SAMPLES 4	// too few samples make the noise estimate meaningless
+
+// accumulates jittered samples of a still into a float target, a few tiles
+// per frame so no single frame runs long enough to trip the driver watchdog.
+// the scene shader must be built with PROGRESSIVE defined. the caller draws
+// the scene or quad between the calls:
+//
+//	beginFrame()
+//	while (nextTile())	-> scene at getWidth() x getHeight()
+//	if (endFrame())		-> a sample pass finished
+//		beginNoise()	-> fullscreen quad
+//		endNoise()
+//	beginPreview()		-> fullscreen quad
+class ProgressiveRenderer
+{
+public:
+	ProgressiveRenderer();
+	~ProgressiveRenderer();
+
+	bool init(ShaderCache &cache, Shader *scene, int width, int height);
+	void release();
+
+	void setTarget(int samples, float noise);
+	void setFrameBudget(float ms);
+
+	void beginFrame();
+	bool nextTile();
+	bool endFrame();
+
+	void beginNoise();
+	float endNoise();
+
+	void beginPreview(int width, int height);
+
+	bool isDone() const;
+	bool save(const char *path) const;
+	void report() const;
+
+	int getWidth() const;
+	int getHeight() const;
+
+private:
+	ProgressiveRenderer(const ProgressiveRenderer &);
+	ProgressiveRenderer &operator = (const ProgressiveRenderer &);
+
+	Shader *scene, *noiseShader, *previewShader;
+	GLFramebuffer fbo, noiseFbo;
+	GLTexture accumulation, moments, noiseTexture;
+	int width, height, tilesX, tilesY;
+
+	int targetSamples;
+	float targetNoise;
+	float frameBudget;
+
+	int samples;		// completed passes over the whole image
+	int tile;			// next tile of the current pass
+	int tilesPerFrame;
+	int tilesThisFrame;
+	float noise;
+
+	double startTime, frameStart;
+	double worstFrame;
+	int frames;
+};
+
+#endif
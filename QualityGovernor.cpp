@@ -0,0 +1,118 @@
+#include "QualityGovernor.h"
+
+#include <stdio.h>
+#include <string.h>
+
+// index 0 is the highest quality and matches the defaults in basic.frag
+const QualityTier QualityGovernor::tiers[] =
+{
+	{ "high", 128, 8.0f, 0.75f, 6 },
+	{ "medium", 80, 6.0f, 0.85f, 4 },
+	{ "low", 48, 4.0f, 0.95f, 4 }
+};
+
+#define SMOOTHING 0.1f			// weight of the newest frame in the running averages
+#define COOLDOWN_FRAMES 30		// frames to settle after a switch before judging again
+#define MAX_UPGRADE_DELAY 1920	// upper bound of the raise back-off
+#define UPGRADE_HEADROOM 0.6f	// only raise when the gpu time is this far under budget
+
+std::string QualityTier::defines() const
+{
+	char buffer[256];
+	sprintf(buffer,
+		"#define MAX_STEPS %d\n"
+		"#define MAX_DEPTH %.2f\n"
+		"#define STEP_FACTOR %.2f\n"
+		"#define NORMAL_TAPS %d\n",
+		maxSteps, maxDepth, stepFactor, normalTaps);
+
+	return buffer;
+}
+
+QualityGovernor::QualityGovernor()
+	: budget(18.0f), gpuAverage(0.0f), frameAverage(0.0f), current(0), framesSinceSwitch(0),
+	upgradeDelay(COOLDOWN_FRAMES), lastWasUpgrade(false), pinned(false) {}
+
+int QualityGovernor::tierCount()
+{
+	return sizeof(tiers) / sizeof(tiers[0]);
+}
+
+const QualityTier &QualityGovernor::tier(int index)
+{
+	return tiers[index];
+}
+
+int QualityGovernor::findTier(const char *name)
+{
+	for (int i = 0; i < tierCount(); ++i)
+		if (strcmp(tiers[i].name, name) == 0)
+			return i;
+
+	return -1;
+}
+
+void QualityGovernor::setBudget(float ms) { budget = ms; }
+
+float QualityGovernor::getBudget() const { return budget; }
+
+void QualityGovernor::pin(int index)
+{
+	current = index;
+	pinned = true;
+}
+
+bool QualityGovernor::isPinned() const { return pinned; }
+
+bool QualityGovernor::update(float gpuMs, float frameMs)
+{
+	// reseed after a switch so the old tier's timings don't linger
+	if (framesSinceSwitch++ == 0)
+	{
+		gpuAverage = gpuMs;
+		frameAverage = frameMs;
+	}
+	else
+	{
+		gpuAverage += (gpuMs - gpuAverage) * SMOOTHING;
+		frameAverage += (frameMs - frameAverage) * SMOOTHING;
+	}
+
+	if (pinned || framesSinceSwitch < COOLDOWN_FRAMES)
+		return false;
+
+	const bool overBudget = gpuAverage > budget || frameAverage > budget;
+
+	if (overBudget && current < tierCount() - 1)
+	{
+		// the last raise didn't hold, wait longer before trying again
+		if (lastWasUpgrade)
+			upgradeDelay = upgradeDelay * 2 < MAX_UPGRADE_DELAY ? upgradeDelay * 2 : MAX_UPGRADE_DELAY;
+
+		++current;
+		lastWasUpgrade = false;
+	}
+	else if (!overBudget && gpuAverage < budget * UPGRADE_HEADROOM &&
+		framesSinceSwitch >= upgradeDelay && current > 0)
+	{
+		// a raise that survived its own cooldown resets the back-off
+		if (lastWasUpgrade)
+			upgradeDelay = COOLDOWN_FRAMES;
+
+		--current;
+		lastWasUpgrade = true;
+	}
+	else
+	{
+		return false;
+	}
+
+	framesSinceSwitch = 0;
+	return true;
+}
+
+int QualityGovernor::getTier() const { return current; }
+
+float QualityGovernor::getGpuAverage() const { return gpuAverage; }
+
+float QualityGovernor::getFrameAverage() const { return frameAverage; }
@@ -0,0 +1,58 @@
+#ifndef QUALITYGOVERNOR_H
+#define QUALITYGOVERNOR_H
+
+#include <string>
+
+// one cost/quality point of the raymarcher, injected into basic.frag as defines
+struct QualityTier
+{
+	const char *name;
+	int maxSteps;
+	float maxDepth;
+	float stepFactor;
+	int normalTaps;
+
+	std::string defines() const;
+};
+
+// picks a quality tier from measured frame time. a tier is dropped when either
+// the frame interval or the gpu time goes over budget, and raised again only
+// when the gpu time shows enough headroom (the frame interval can't, it is
+// clamped to the vsync interval). raises that get reverted straight away back
+// off exponentially so the tier doesn't oscillate
+class QualityGovernor
+{
+public:
+	QualityGovernor();
+
+	static int tierCount();
+	static const QualityTier &tier(int index);
+	static int findTier(const char *name);
+
+	void setBudget(float ms);
+	float getBudget() const;
+
+	// a pinned governor never switches tiers
+	void pin(int index);
+	bool isPinned() const;
+
+	// feed one frame, returns true if the tier changed
+	bool update(float gpuMs, float frameMs);
+
+	int getTier() const;
+	float getGpuAverage() const;
+	float getFrameAverage() const;
+
+private:
+	static const QualityTier tiers[];
+
+	float budget;
+	float gpuAverage, frameAverage;
+	int current;
+	int framesSinceSwitch;
+	int upgradeDelay;
+	bool lastWasUpgrade;
+	bool pinned;
+};
+
+#endif
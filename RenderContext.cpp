@@ -0,0 +1,235 @@
+#include "RenderContext.h"
+#include "GpuTimer.h"
+
+#include <stdio.h>
+
+// std140 layout of the Frame block
+struct FrameUniforms
+{
+	float resolution[2];
+	float time;
+	float padding;
+};
+
+ContextStats::ContextStats() : frames(0), seconds(0.0), cpuMs(0.0), worstMs(0.0), gpuMs(0.0), pixels(0.0) {}
+
+RenderContext::RenderContext()
+	: window(NULL), running(false), width(0), height(0), index(0), offscreen(false),
+	scene(NULL), quad(NULL), frames(0) {}
+
+RenderContext::~RenderContext()
+{
+	join();
+	destroy();
+}
+
+bool RenderContext::create(int index, GLFWwindow *share, bool offscreen, int width, int height)
+{
+	this->index = index;
+	this->offscreen = offscreen;
+	this->width = width;
+	this->height = height;
+
+	char title[64];
+	sprintf(title, "Simple example %d", index);
+
+	glfwWindowHint(GLFW_VISIBLE, offscreen ? GL_FALSE : GL_TRUE);
+	if (!(window = glfwCreateWindow(width, height, title, NULL, share)))
+	{
+		printf("Failed to create context %d!\n", index);
+		return false;
+	}
+
+	return true;
+}
+
+void RenderContext::destroy()
+{
+	if (window)
+		glfwDestroyWindow(window);
+
+	window = NULL;
+}
+
+void RenderContext::start(Shader &scene, const Mesh &quad, int frames)
+{
+	this->scene = &scene;
+	this->quad = &quad;
+	this->frames = frames;
+	stats = ContextStats();
+
+	running = true;
+	thread = std::thread(&RenderContext::run, this);
+}
+
+bool RenderContext::isRunning() const
+{
+	return running;
+}
+
+void RenderContext::join()
+{
+	if (thread.joinable())
+		thread.join();
+}
+
+void RenderContext::updateSize()
+{
+	if (offscreen || !window)
+		return;
+
+	int w, h;
+	glfwGetFramebufferSize(window, &w, &h);
+	width = w;
+	height = h;
+}
+
+const ContextStats &RenderContext::getStats() const
+{
+	return stats;
+}
+
+GLFWwindow *RenderContext::getWindow() const
+{
+	return window;
+}
+
+int RenderContext::getIndex() const
+{
+	return index;
+}
+
+bool RenderContext::isOffscreen() const
+{
+	return offscreen;
+}
+
+// everything made in render() is released before the context is let go
+void RenderContext::run()
+{
+	glfwMakeContextCurrent(window);
+
+	// throughput is what's measured, not the refresh rate
+	glfwSwapInterval(0);
+
+	if (!render())
+		printf("Context %d failed!\n", index);
+
+	glfwMakeContextCurrent(NULL);
+	running = false;
+}
+
+bool RenderContext::render()
+{
+	GLVertexArray vertexArray;
+	GLBuffer uniformBuffer;
+	GLFramebuffer target;
+	GLTexture color;
+	GpuTimer timer;
+
+	if (!quad->createVertexArray(vertexArray) || !uniformBuffer.create() || !timer.init())
+		return false;
+
+	glBindBuffer(GL_UNIFORM_BUFFER, uniformBuffer.get());
+	glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameUniforms), NULL, GL_STREAM_DRAW);
+	uniformBuffer.setBytes(sizeof(FrameUniforms));
+	glBindBufferBase(GL_UNIFORM_BUFFER, CONTEXT_FRAME_BINDING, uniformBuffer.get());
+
+	// offscreen targets keep their size, windows follow updateSize()
+	if (offscreen)
+	{
+		color.create();
+		glBindTexture(GL_TEXTURE_2D, color.get());
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glBindTexture(GL_TEXTURE_2D, 0);
+		color.setBytes(textureBytes(GL_RGBA8, width, height));
+
+		target.create();
+		glBindFramebuffer(GL_FRAMEBUFFER, target.get());
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, color.get(), 0);
+		if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+			return false;
+	}
+
+	GLsync fences[CONTEXT_FRAMES_IN_FLIGHT] = {};
+	double gpuTotal = 0.0;
+	int gpuResults = 0;
+
+	const double start = glfwGetTime();
+	double lastFrame = start;
+
+	while (!glfwWindowShouldClose(window) && (frames == 0 || stats.frames < frames))
+	{
+		const int w = width, h = height;
+		const double frameStart = glfwGetTime();
+
+		// the interval holding the first frame is left out, like its gpu time
+		if (stats.frames > 1)
+		{
+			const double ms = (frameStart - lastFrame) * 1000.0;
+			stats.cpuMs += ms;
+			if (ms > stats.worstMs)
+				stats.worstMs = ms;
+		}
+
+		lastFrame = frameStart;
+
+		double ms;
+		if (timer.poll(ms))
+		{
+			gpuTotal += ms;
+			++gpuResults;
+		}
+
+		// orphaned each frame so the update never waits on the last draw
+		const FrameUniforms uniforms = { { (float)w, (float)h }, (float)frameStart, 0.0f };
+		glBindBuffer(GL_UNIFORM_BUFFER, uniformBuffer.get());
+		glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameUniforms), NULL, GL_STREAM_DRAW);
+		glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameUniforms), &uniforms);
+
+		// the first frame pays for this context's first use of the program
+		if (stats.frames > 0)
+			timer.begin();
+
+		glViewport(0, 0, w, h);
+		scene->bind();
+		quad->draw(vertexArray);
+
+		if (stats.frames > 0)
+			timer.end();
+
+		if (offscreen)
+		{
+			// a swap would throttle the thread, the fences do it instead
+			GLsync &fence = fences[stats.frames % CONTEXT_FRAMES_IN_FLIGHT];
+			if (fence)
+			{
+				glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+				glDeleteSync(fence);
+			}
+
+			fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		}
+		else
+			glfwSwapBuffers(window);
+
+		++stats.frames;
+		stats.pixels += (double)w * h;
+	}
+
+	glFinish();
+	stats.seconds = glfwGetTime() - start;
+	if (stats.frames > 2)
+		stats.cpuMs /= stats.frames - 2;
+
+	stats.gpuMs = gpuResults > 0 ? gpuTotal / gpuResults : 0.0;
+
+	for (int i = 0; i < CONTEXT_FRAMES_IN_FLIGHT; ++i)
+		if (fences[i])
+			glDeleteSync(fences[i]);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glBindVertexArray(0);
+	return true;
+}
@@ -0,0 +1,83 @@
+#ifndef RENDERCONTEXT_H
+#define RENDERCONTEXT_H
+
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+#include <atomic>
+#include <thread>
+#include "GLResource.h"
+#include "Mesh.h"
+#include "Shader.h"
+
+#define CONTEXT_FRAME_BINDING 0		// uniform buffer binding of the Frame block in scene.glsl
+#define CONTEXT_FRAMES_IN_FLIGHT 2	// offscreen frames queued before the render thread waits
+#define CONTEXT_DEFAULT_FRAMES 120	// frames per offscreen context when no count is given
+
+// what one context rendered, read once its thread has finished
+struct ContextStats
+{
+	ContextStats();
+
+	int frames;
+	double seconds;
+	double cpuMs, worstMs;	// time between frame starts
+	double gpuMs;			// average of the timer query results
+	double pixels;
+};
+
+// a window or offscreen target with its own context and render thread. the
+// context shares with the main one, which owns the programs and the static
+// buffers. what can't be shared (vertex array, framebuffer, queries, fences)
+// or must differ per context (the Frame uniform block) is made on the
+// render thread
+//
+//	create()		-> main thread, glfw only makes windows there
+//	start()
+//	while (isRunning())
+//		updateSize()	-> main thread, with the event polling
+//	join()
+//	destroy()		-> main thread
+class RenderContext
+{
+public:
+	RenderContext();
+	~RenderContext();
+
+	// hidden windows render into a framebuffer instead of swapping
+	bool create(int index, GLFWwindow *share, bool offscreen, int width, int height);
+	void destroy();
+
+	// the scene must be built with FRAME_BLOCK defined, 0 frames runs until
+	// the window is closed
+	void start(Shader &scene, const Mesh &quad, int frames);
+	bool isRunning() const;
+	void join();
+
+	void updateSize();
+
+	const ContextStats &getStats() const;
+	GLFWwindow *getWindow() const;
+	int getIndex() const;
+	bool isOffscreen() const;
+
+private:
+	RenderContext(const RenderContext &);
+	RenderContext &operator = (const RenderContext &);
+
+	void run();
+	bool render();
+
+	GLFWwindow *window;
+	std::thread thread;
+	std::atomic<bool> running;
+	std::atomic<int> width, height;
+	int index;
+	bool offscreen;
+
+	Shader *scene;
+	const Mesh *quad;
+	int frames;
+	ContextStats stats;
+};
+
+#endif
@@ -0,0 +1,518 @@
+#include "RenderFarm.h"
+
+#include <algorithm>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "QualityGovernor.h"
+
+// every message is a header and size bytes of payload, both ends are the same
+// executable so structs go over the wire as they are
+enum FarmMessage
+{
+	FARM_JOB = 1,	// coordinator -> worker, a TileJob
+	FARM_RESULT,	// worker -> coordinator, the job id and its pixels
+	FARM_QUIT		// coordinator -> worker
+};
+
+struct MessageHeader
+{
+	unsigned int type;
+	unsigned int size;
+};
+
+static bool sendMessage(Socket &socket, unsigned int type, const void *payload, unsigned int size)
+{
+	std::vector<char> message(sizeof(MessageHeader) + size);
+
+	MessageHeader header = { type, size };
+	memcpy(&message[0], &header, sizeof(header));
+	if (size > 0)
+		memcpy(&message[sizeof(header)], payload, size);
+
+	return socket.sendAll(&message[0], message.size());
+}
+
+FarmSettings::FarmSettings()
+	: workers(0), frames(8), frameRate(30.0f), width(1280), height(720), tileSize(64), tier(0),
+	useGL(false), fault(false), scaling(false), output("frame_") {}
+
+RenderFarm::RenderFarm()
+	: tilesX(0), tilesY(0), nextFrame(0), framesDone(0), requeued(0), start(0.0) {}
+
+RenderFarm::~RenderFarm()
+{
+	shutdown();
+}
+
+// renders the sequence once, or once per worker count with --farm-scaling
+bool RenderFarm::run(const FarmSettings &farmSettings)
+{
+	settings = farmSettings;
+	tilesX = (settings.width + settings.tileSize - 1) / settings.tileSize;
+	tilesY = (settings.height + settings.tileSize - 1) / settings.tileSize;
+
+	printf("Render farm: %d frames of %dx%d, %d tiles each, %s tier, %s workers\n",
+		settings.frames, settings.width, settings.height, tilesX * tilesY,
+		QualityGovernor::tier(settings.tier).name, settings.useGL ? "gl" : "cpu");
+
+	double seconds;
+	if (!settings.scaling)
+		return render(settings.workers, seconds);
+
+	std::vector<double> times;
+	for (int count = 1; count <= settings.workers; ++count)
+	{
+		if (!render(count, seconds))
+			return false;
+
+		times.push_back(seconds);
+	}
+
+	printf("Render farm scaling:\n");
+	printf("%-8s %10s %10s %10s %11s\n", "workers", "seconds", "frames/s", "speedup", "efficiency");
+
+	for (size_t i = 0; i < times.size(); ++i)
+	{
+		const double speedup = times[0] / times[i];
+		printf("%-8d %10.2f %10.2f %9.2fx %10.1f%%\n",
+			(int)i + 1, times[i], settings.frames / times[i], speedup, 100.0 * speedup / (i + 1));
+	}
+
+	return true;
+}
+
+bool RenderFarm::render(int workerCount, double &seconds)
+{
+	nextFrame = framesDone = requeued = 0;
+	frames.clear();
+
+	if (!launch(workerCount))
+	{
+		shutdown();
+		return false;
+	}
+
+	start = now();
+	for (int i = 0; i < FARM_FRAMES_IN_FLIGHT; ++i)
+		queueFrame();
+
+	bool success = true;
+	while (framesDone < settings.frames)
+	{
+		if (liveWorkers() == 0)
+		{
+			printf("All render farm workers failed!\n");
+			success = false;
+			break;
+		}
+
+		dispatch();
+
+		std::vector<Socket*> sockets;
+		std::vector<Worker*> owners;
+		for (std::vector<Worker*>::iterator it = workers.begin(); it != workers.end(); ++it)
+		{
+			if (!(*it)->alive)
+				continue;
+
+			sockets.push_back(&(*it)->socket);
+			owners.push_back(*it);
+		}
+
+		std::vector<bool> readable;
+		Socket::select(sockets, readable, 100);
+
+		for (size_t i = 0; i < owners.size(); ++i)
+		{
+			if (readable[i] && owners[i]->alive && !receive(*owners[i]))
+				fail(*owners[i], "lost its connection");
+		}
+
+		// a hung worker never closes its socket
+		for (std::vector<Worker*>::iterator it = workers.begin(); it != workers.end(); ++it)
+		{
+			if ((*it)->alive && !(*it)->inFlight.empty() && now() - (*it)->lastReply > FARM_TILE_TIMEOUT)
+				fail(**it, "timed out");
+		}
+	}
+
+	seconds = now() - start;
+
+	if (success)
+	{
+		const double pixels = (double)settings.width * settings.height * settings.frames;
+		printf("%d workers: %d frames in %.2f s, %.2f frames/s, %.2f Mpixels/s, %d tiles requeued\n",
+			workerCount, settings.frames, seconds, settings.frames / seconds, pixels / seconds / 1000000.0, requeued);
+
+		for (size_t i = 0; i < workers.size(); ++i)
+		{
+			printf("  worker %-3d %6d tiles %6d stolen%s\n",
+				(int)i, workers[i]->rendered, workers[i]->stolen, workers[i]->alive ? "" : " (failed)");
+		}
+	}
+
+	shutdown();
+	return success;
+}
+
+// starts the workers one at a time, so each connection belongs to the process
+// that was just spawned
+bool RenderFarm::launch(int count)
+{
+	if (!listener.listen("127.0.0.1", 0))
+	{
+		printf("Failed to open the render farm socket!\n");
+		return false;
+	}
+
+	char address[32];
+	sprintf(address, "127.0.0.1:%d", listener.getPort());
+
+	for (int i = 0; i < count; ++i)
+	{
+		Worker *worker = new Worker();
+		worker->lastReply = 0.0;
+		worker->rendered = worker->stolen = 0;
+		worker->alive = false;
+		workers.push_back(worker);
+
+		std::vector<std::string> args;
+		args.push_back(settings.executable);
+		args.push_back("--worker");
+		args.push_back(address);
+
+		if (settings.useGL)
+			args.push_back("--worker-gl");
+
+		// with a single worker there would be nobody left to take over
+		if (settings.fault && i == 0 && count > 1)
+		{
+			char tiles[16];
+			sprintf(tiles, "%d", FARM_FAULT_TILES);
+			args.push_back("--fail-after");
+			args.push_back(tiles);
+		}
+
+		if (!worker->process.spawn(args))
+		{
+			printf("Failed to launch render farm worker %s!\n", settings.executable.c_str());
+			return false;
+		}
+
+		std::vector<Socket*> sockets(1, &listener);
+		std::vector<bool> readable;
+		if (!Socket::select(sockets, readable, FARM_CONNECT_TIMEOUT) || !listener.accept(worker->socket))
+		{
+			printf("Render farm worker %d didn't connect!\n", i);
+			return false;
+		}
+
+		// select only says a reply has started, the rest of it gets the
+		// same time as a tile
+		worker->socket.setReceiveTimeout((int)(FARM_TILE_TIMEOUT * 1000.0));
+
+		worker->alive = true;
+	}
+
+	return true;
+}
+
+void RenderFarm::shutdown()
+{
+	for (std::vector<Worker*>::iterator it = workers.begin(); it != workers.end(); ++it)
+	{
+		Worker *worker = *it;
+		if (worker->alive)
+			sendMessage(worker->socket, FARM_QUIT, NULL, 0);
+		else
+			worker->process.kill();
+
+		worker->socket.close();
+		worker->process.wait();
+		delete worker;
+	}
+
+	workers.clear();
+	listener.close();
+}
+
+// deals the next frame's tiles out in contiguous blocks, neighbouring tiles
+// cost about the same so blocks keep the workers evenly loaded to begin with
+void RenderFarm::queueFrame()
+{
+	if (nextFrame >= settings.frames)
+		return;
+
+	const int frame = nextFrame++;
+	const int count = tilesX * tilesY;
+
+	Frame &image = frames[frame];
+	image.rgb.assign(settings.width * settings.height * 3, 0);
+	image.remaining = count;
+
+	std::vector<Worker*> live;
+	for (std::vector<Worker*>::iterator it = workers.begin(); it != workers.end(); ++it)
+	{
+		if ((*it)->alive)
+			live.push_back(*it);
+	}
+
+	if (live.empty())
+		return;
+
+	for (int tile = 0; tile < count; ++tile)
+		live[tile * live.size() / count]->queue.push_back(frame * count + tile);
+}
+
+// own tiles come off the front, stolen ones off the back of the longest queue
+// where they are furthest from what its owner is working on
+bool RenderFarm::take(Worker &worker, unsigned int &tile)
+{
+	if (!worker.queue.empty())
+	{
+		tile = worker.queue.front();
+		worker.queue.pop_front();
+		return true;
+	}
+
+	Worker *victim = NULL;
+	for (std::vector<Worker*>::iterator it = workers.begin(); it != workers.end(); ++it)
+	{
+		if ((*it)->alive && !(*it)->queue.empty() && (!victim || (*it)->queue.size() > victim->queue.size()))
+			victim = *it;
+	}
+
+	if (!victim)
+		return false;
+
+	tile = victim->queue.back();
+	victim->queue.pop_back();
+	++worker.stolen;
+	return true;
+}
+
+// keeps every worker's pipeline full
+bool RenderFarm::dispatch()
+{
+	bool sent = false;
+
+	for (std::vector<Worker*>::iterator it = workers.begin(); it != workers.end(); ++it)
+	{
+		Worker &worker = **it;
+
+		unsigned int tile;
+		while (worker.alive && worker.inFlight.size() < FARM_PIPELINE_DEPTH && take(worker, tile))
+		{
+			if (worker.inFlight.empty())
+				worker.lastReply = now();
+
+			worker.inFlight.push_back(tile);
+
+			const TileJob job = makeJob(tile);
+			if (!sendMessage(worker.socket, FARM_JOB, &job, sizeof(job)))
+				fail(worker, "stopped accepting tiles");
+
+			sent = true;
+		}
+	}
+
+	return sent;
+}
+
+bool RenderFarm::receive(Worker &worker)
+{
+	MessageHeader header;
+	unsigned int id;
+	if (!worker.socket.recvAll(&header, sizeof(header)) || header.type != FARM_RESULT ||
+		header.size < sizeof(id) || !worker.socket.recvAll(&id, sizeof(id)))
+		return false;
+
+	std::vector<unsigned int>::iterator pending = std::find(worker.inFlight.begin(), worker.inFlight.end(), id);
+	if (pending == worker.inFlight.end())
+		return false;
+
+	const TileJob job = makeJob(id);
+	const unsigned int rowBytes = job.w * 3;
+	if (header.size != sizeof(id) + rowBytes * job.h)
+		return false;
+
+	std::vector<unsigned char> rgb(rowBytes * job.h);
+	if (!worker.socket.recvAll(&rgb[0], rgb.size()))
+		return false;
+
+	worker.inFlight.erase(pending);
+	worker.lastReply = now();
+	++worker.rendered;
+
+	Frame &image = frames[job.frame];
+	for (unsigned int y = 0; y < job.h; ++y)
+		memcpy(&image.rgb[((job.y + y) * settings.width + job.x) * 3], &rgb[y * rowBytes], rowBytes);
+
+	if (--image.remaining == 0)
+	{
+		saveFrame(job.frame, image);
+		frames.erase(job.frame);
+		++framesDone;
+		queueFrame();
+	}
+
+	return true;
+}
+
+// the worker's tiles go to the front of the shortest queues, the frames they
+// belong to are the ones holding everything up
+void RenderFarm::fail(Worker &worker, const char *reason)
+{
+	std::vector<unsigned int> orphans(worker.inFlight.begin(), worker.inFlight.end());
+	orphans.insert(orphans.end(), worker.queue.begin(), worker.queue.end());
+
+	const int index = (int)(std::find(workers.begin(), workers.end(), &worker) - workers.begin());
+	printf("Render farm worker %d %s, requeueing %d tiles.\n", index, reason, (int)orphans.size());
+
+	worker.alive = false;
+	worker.inFlight.clear();
+	worker.queue.clear();
+	worker.socket.close();
+	worker.process.kill();
+
+	for (std::vector<unsigned int>::reverse_iterator tile = orphans.rbegin(); tile != orphans.rend(); ++tile)
+	{
+		Worker *shortest = NULL;
+		for (std::vector<Worker*>::iterator it = workers.begin(); it != workers.end(); ++it)
+		{
+			if ((*it)->alive && (!shortest || (*it)->queue.size() < shortest->queue.size()))
+				shortest = *it;
+		}
+
+		if (!shortest)
+			return;
+
+		shortest->queue.push_front(*tile);
+		++requeued;
+	}
+}
+
+// binary ppm, flipped to top down
+bool RenderFarm::saveFrame(int frame, const Frame &image) const
+{
+	if (settings.output.empty())
+		return true;
+
+	char path[512];
+	sprintf(path, "%s%04d.ppm", settings.output.c_str(), frame);
+
+	FILE *file = fopen(path, "wb");
+	if (!file)
+	{
+		printf("Failed to write %s!\n", path);
+		return false;
+	}
+
+	fprintf(file, "P6\n%d %d\n255\n", settings.width, settings.height);
+	for (int y = settings.height - 1; y >= 0; --y)
+		fwrite(&image.rgb[y * settings.width * 3], 3, settings.width, file);
+
+	fclose(file);
+	return true;
+}
+
+TileJob RenderFarm::makeJob(unsigned int id) const
+{
+	const int count = tilesX * tilesY;
+	const int tile = id % count;
+
+	TileJob job;
+	job.id = id;
+	job.frame = id / count;
+	job.time = job.frame / settings.frameRate;
+	job.tier = settings.tier;
+	job.width = settings.width;
+	job.height = settings.height;
+	job.x = (tile % tilesX) * settings.tileSize;
+	job.y = (tile / tilesX) * settings.tileSize;
+	job.w = std::min(settings.tileSize, settings.width - (int)job.x);
+	job.h = std::min(settings.tileSize, settings.height - (int)job.y);
+	return job;
+}
+
+int RenderFarm::liveWorkers() const
+{
+	int count = 0;
+	for (std::vector<Worker*>::const_iterator it = workers.begin(); it != workers.end(); ++it)
+	{
+		if ((*it)->alive)
+			++count;
+	}
+
+	return count;
+}
+
+double RenderFarm::now() const
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+bool RenderFarm::work(const char *address, TileRenderer &renderer, int failAfter)
+{
+	const char *colon = strrchr(address, ':');
+	if (!colon)
+	{
+		printf("Expected HOST:PORT after --worker!\n");
+		return false;
+	}
+
+	const std::string host(address, colon);
+	Socket socket;
+	if (!socket.connect(host.c_str(), (unsigned short)atoi(colon + 1)))
+	{
+		printf("Failed to connect to the render farm at %s!\n", address);
+		return false;
+	}
+
+	// the result is rendered straight into the message behind its header
+	const size_t offset = sizeof(MessageHeader) + sizeof(unsigned int);
+	std::vector<unsigned char> message;
+
+	for (int tiles = 0;; ++tiles)
+	{
+		MessageHeader header;
+		if (!socket.recvAll(&header, sizeof(header)))
+		{
+			printf("Lost the render farm coordinator!\n");
+			return false;
+		}
+
+		if (header.type == FARM_QUIT)
+			return true;
+
+		TileJob job;
+		if (header.type != FARM_JOB || header.size != sizeof(job) || !socket.recvAll(&job, sizeof(job)))
+		{
+			printf("Unexpected render farm message!\n");
+			return false;
+		}
+
+		if (failAfter > 0 && tiles == failAfter)
+		{
+			printf("Simulating a render farm worker failure.\n");
+			return false;
+		}
+
+		message.resize(offset + job.w * job.h * 3);
+		if (!renderer.renderTile(job, &message[offset]))
+		{
+			printf("Failed to render tile %u!\n", job.id);
+			return false;
+		}
+
+		header.type = FARM_RESULT;
+		header.size = (unsigned int)(message.size() - sizeof(header));
+		memcpy(&message[0], &header, sizeof(header));
+		memcpy(&message[sizeof(header)], &job.id, sizeof(job.id));
+
+		if (!socket.sendAll(&message[0], message.size()))
+			return false;
+	}
+}
@@ -0,0 +1,100 @@
+#ifndef RENDERFARM_H
+#define RENDERFARM_H
+
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+#include "Process.h"
+#include "Socket.h"
+#include "TileRenderer.h"
+
+#define FARM_PIPELINE_DEPTH 2		// tiles sent ahead to each worker, hides the round trip
+#define FARM_FRAMES_IN_FLIGHT 2		// frames whose tiles are queued at once, bounds memory on long sequences
+#define FARM_CONNECT_TIMEOUT 10000	// ms a spawned worker gets to connect
+#define FARM_TILE_TIMEOUT 30.0		// seconds before a silent worker is given up on
+#define FARM_FAULT_TILES 3			// tiles the worker rendered before --farm-fault kills it
+
+// what the coordinator renders and how
+struct FarmSettings
+{
+	FarmSettings();
+
+	int workers;
+	int frames;
+	float frameRate;
+	int width, height;
+	int tileSize;
+	int tier;
+	bool useGL;				// workers render with a hidden gl window instead of CpuRenderer
+	bool fault;				// the first worker dies after a few tiles, to exercise the requeue
+	bool scaling;			// render once per worker count and report the efficiency
+	std::string output;		// frame file prefix, nothing is written when empty
+	std::string executable;	// what to launch the workers from
+};
+
+// renders an animation sequence on worker processes launched on this machine.
+// every frame is cut into tiles that are dealt out to the workers in blocks,
+// a worker that runs dry steals from the back of the longest queue, and the
+// tiles of a worker that dies or goes silent are handed to the others. the
+// workers are this executable started with --worker
+class RenderFarm
+{
+public:
+	RenderFarm();
+	~RenderFarm();
+
+	// coordinator side
+	bool run(const FarmSettings &settings);
+
+	// worker side, renders tiles until told to quit. failAfter > 0 drops the
+	// connection after that many tiles as if the worker crashed
+	static bool work(const char *address, TileRenderer &renderer, int failAfter);
+
+private:
+	struct Worker
+	{
+		Socket socket;
+		Process process;
+		std::deque<unsigned int> queue;
+		std::vector<unsigned int> inFlight;
+		double lastReply;
+		int rendered, stolen;
+		bool alive;
+	};
+
+	struct Frame
+	{
+		std::vector<unsigned char> rgb;
+		int remaining;
+	};
+
+	RenderFarm(const RenderFarm &);
+	RenderFarm &operator = (const RenderFarm &);
+
+	bool render(int workerCount, double &seconds);
+	bool launch(int count);
+	void shutdown();
+
+	void queueFrame();
+	bool take(Worker &worker, unsigned int &tile);
+	bool dispatch();
+	bool receive(Worker &worker);
+	void fail(Worker &worker, const char *reason);
+	bool saveFrame(int frame, const Frame &image) const;
+
+	TileJob makeJob(unsigned int id) const;
+	int liveWorkers() const;
+	double now() const;
+
+	FarmSettings settings;
+	Socket listener;
+	std::vector<Worker*> workers;
+	std::map<int, Frame> frames; // in flight
+	int tilesX, tilesY;
+	int nextFrame, framesDone;
+	int requeued;
+	double start;
+};
+
+#endif
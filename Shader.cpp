@@ -2,6 +2,7 @@
 
 #include <fstream>
 #include <iostream>
+#include <stdio.h>
 #include <string>
 #include <vector>
 
@@ -9,144 +10,193 @@ using namespace std;
 
 Shader::Shader() {}
 
-Shader::~Shader()
+Shader::~Shader() {}
+
+void Shader::bind() const
 {
-	glDeleteProgram(shader);
+    glUseProgram(program.get());
 }
 
-void Shader::bind() const
+static std::string directoryOf(const std::string &path)
 {
-    glUseProgram(shader);
+	const size_t slash = path.find_last_of("/\\");
+	return slash == std::string::npos ? "" : path.substr(0, slash + 1);
 }
 
-bool Shader::attachVertexShader(const char *vertex_file_path, const std::string &strBefore)
+// append a file to code, replacing #include "file" lines by that file (looked
+// up next to the includer) and keeping #line in step for error messages
+static bool appendFile(const std::string &file_path, std::string &code, int depth)
 {
-    vertexShaders.push_back(glCreateShader(GL_VERTEX_SHADER));
-    GLuint VertexShaderID = vertexShaders.back();
-    
-    // Read the Vertex Shader code from the file
-	std::string VertexShaderCode = strBefore + "\n";
-	std::ifstream VertexShaderStream(vertex_file_path, std::ios::in);
-	if (VertexShaderStream.is_open())
+	if (depth > 8)
 	{
-		std::string Line = "";
-
-		while(getline(VertexShaderStream, Line))
-			VertexShaderCode += "\n" + Line;
-
-		VertexShaderStream.close();
+		cout << "Includes nested too deep in " << file_path << "!\n";
+		return false;
 	}
-	else
+
+	std::ifstream stream(file_path.c_str(), std::ios::in);
+	if (!stream.is_open())
 	{
-		cout << "Failed to open " << vertex_file_path << "!\n";
-		getchar();
+		cout << "Failed to open " << file_path << "!\n";
 		return false;
 	}
-    
-    // Compile Vertex Shader
-    cout << "Compiling vertex shader: " << vertex_file_path << endl;
-	char const * VertexSourcePointer = VertexShaderCode.c_str();
-	glShaderSource(VertexShaderID, 1, &VertexSourcePointer , NULL);
-	glCompileShader(VertexShaderID);
-    
-	// Check Vertex Shader
-	glGetShaderiv(VertexShaderID, GL_COMPILE_STATUS, &Result);
-	glGetShaderiv(VertexShaderID, GL_INFO_LOG_LENGTH, &InfoLogLength);
-	if (InfoLogLength > 0)
+
+	std::string Line = "";
+	int lineNumber = 0;
+
+	while (getline(stream, Line))
 	{
-		std::vector<char> VertexShaderErrorMessage(InfoLogLength+1);
-		glGetShaderInfoLog(VertexShaderID, InfoLogLength, NULL, &VertexShaderErrorMessage[0]);
-        cout << &VertexShaderErrorMessage[0] << endl;
+		++lineNumber;
 
-        return false;
+		if (Line.compare(0, 10, "#include \"") == 0)
+		{
+			const std::string included = Line.substr(10, Line.find('"', 10) - 10);
+
+			code += "#line 1\n";
+			if (!appendFile(directoryOf(file_path) + included, code, depth + 1))
+				return false;
+
+			char restore[32];
+			sprintf(restore, "#line %d\n", lineNumber + 1);
+			code += restore;
+			continue;
+		}
+
+		code += Line + "\n";
 	}
-    
-    return true;
+
+	stream.close();
+	return true;
 }
 
-bool Shader::attachFragmentShader(const char *fragment_file_path, const std::string &strBefore)
+// read a shader file, injecting strBefore (usually #defines) right after the
+// #version line so permutations still compile
+static bool readSource(const char *file_path, const std::string &strBefore, std::string &code)
 {
-    fragmentShaders.push_back(glCreateShader(GL_FRAGMENT_SHADER));
-    GLuint FragmentShaderID = fragmentShaders.back();
-    
-    std::string FragmentShaderCode = strBefore + "\n";
-	std::ifstream FragmentShaderStream(fragment_file_path, std::ios::in);
-	if (FragmentShaderStream.is_open())
+	std::string body;
+	if (!appendFile(file_path, body, 0))
+		return false;
+
+	if (body.compare(0, 8, "#version") == 0)
 	{
-		std::string Line = "";
+		const size_t end = body.find('\n') + 1;
+		code = body.substr(0, end) + strBefore + "\n#line 2\n" + body.substr(end);
+	}
+	else
+		code = strBefore + "\n" + body;
 
-		while(getline(FragmentShaderStream, Line))
-			FragmentShaderCode += "\n" + Line;
+	return true;
+}
 
-		FragmentShaderStream.close();
-	}
-    
-    // Compile Fragment Shader
-    cout << "Compiling fragment shader: " << fragment_file_path << endl;
-	char const * FragmentSourcePointer = FragmentShaderCode.c_str();
-	glShaderSource(FragmentShaderID, 1, &FragmentSourcePointer , NULL);
-	glCompileShader(FragmentShaderID);
-    
-	// Check Fragment Shader
-	glGetShaderiv(FragmentShaderID, GL_COMPILE_STATUS, &Result);
-	glGetShaderiv(FragmentShaderID, GL_INFO_LOG_LENGTH, &InfoLogLength);
-	if (InfoLogLength > 0)
+// compile a single stage, printing the info log on failure. the stage object
+// is kept either way so it gets freed with the shader
+bool Shader::attach(GLenum stage, const char *file_path, const std::string &code)
+{
+	stages.push_back(GLShaderObject());
+	if (!stages.back().create(stage))
+		return false;
+
+	const GLuint id = stages.back().get();
+	char const * SourcePointer = code.c_str();
+	glShaderSource(id, 1, &SourcePointer, NULL);
+	glCompileShader(id);
+
+	glGetShaderiv(id, GL_COMPILE_STATUS, &Result);
+	glGetShaderiv(id, GL_INFO_LOG_LENGTH, &InfoLogLength);
+	if (InfoLogLength > 1)
 	{
-		std::vector<char> FragmentShaderErrorMessage(InfoLogLength+1);
-		glGetShaderInfoLog(FragmentShaderID, InfoLogLength, NULL, &FragmentShaderErrorMessage[0]);
+		std::vector<char> ShaderErrorMessage(InfoLogLength+1);
+		glGetShaderInfoLog(id, InfoLogLength, NULL, &ShaderErrorMessage[0]);
+		cout << file_path << ":\n" << &ShaderErrorMessage[0] << endl;
+	}
+
+	return Result == GL_TRUE;
+}
 
-        cout << &FragmentShaderErrorMessage[0] << endl;
+bool Shader::attachVertexShader(const char *vertex_file_path, const std::string &strBefore)
+{
+	// Read the Vertex Shader code from the file
+	std::string VertexShaderCode;
+	if (!readSource(vertex_file_path, strBefore, VertexShaderCode))
+	{
+		getchar();
+		return false;
 	}
-    
-    return true;
+
+	// Compile Vertex Shader
+	cout << "Compiling vertex shader: " << vertex_file_path << endl;
+	return attach(GL_VERTEX_SHADER, vertex_file_path, VertexShaderCode);
+}
+
+bool Shader::attachFragmentShader(const char *fragment_file_path, const std::string &strBefore)
+{
+	std::string FragmentShaderCode;
+	if (!readSource(fragment_file_path, strBefore, FragmentShaderCode))
+		return false;
+
+	// Compile Fragment Shader
+	cout << "Compiling fragment shader: " << fragment_file_path << endl;
+	return attach(GL_FRAGMENT_SHADER, fragment_file_path, FragmentShaderCode);
+}
+
+bool Shader::attachComputeShader(const char *compute_file_path, const std::string &strBefore)
+{
+	std::string ComputeShaderCode;
+	if (!readSource(compute_file_path, strBefore, ComputeShaderCode))
+		return false;
+
+	// Compile Compute Shader
+	cout << "Compiling compute shader: " << compute_file_path << endl;
+	return attach(GL_COMPUTE_SHADER, compute_file_path, ComputeShaderCode);
 }
 
 bool Shader::link()
 {
     // Link the program
 	cout << "Linking program...\n";
-    shader = glCreateProgram();
-    
-    for (std::vector<GLuint>::iterator i = vertexShaders.begin(); i != vertexShaders.end(); ++i)
-        glAttachShader(shader, *i);
-    
-    for (std::vector<GLuint>::iterator i = fragmentShaders.begin(); i != fragmentShaders.end(); ++i)
-        glAttachShader(shader, *i);
+    if (!program.create())
+        return false;
+
+    const GLuint shader = program.get();
+
+    for (std::vector<GLShaderObject>::iterator i = stages.begin(); i != stages.end(); ++i)
+        glAttachShader(shader, i->get());
     
 	glLinkProgram(shader);
     
 	// Check the program
 	glGetProgramiv(shader, GL_LINK_STATUS, &Result);
 	glGetProgramiv(shader, GL_INFO_LOG_LENGTH, &InfoLogLength);
-	if (InfoLogLength > 0)
+	if (InfoLogLength > 1)
 	{
 		std::vector<char> ProgramErrorMessage(InfoLogLength+1);
 		glGetProgramInfoLog(shader, InfoLogLength, NULL, &ProgramErrorMessage[0]);
 
         cout << &ProgramErrorMessage[0] << endl;
-        return false;
 	}
-    
-    for (std::vector<GLuint>::iterator i = vertexShaders.begin(); i != vertexShaders.end(); ++i)
-        glDeleteShader(*i);
-    
-    for (std::vector<GLuint>::iterator i = fragmentShaders.begin(); i != fragmentShaders.end(); ++i)
-        glDeleteShader(*i);
+
+    // the program keeps what it needs, deleting attached stages just flags them
+    stages.clear();
+
+	if (Result != GL_TRUE)
+	{
+		program.reset();
+		return false;
+	}
     
     return true;
 }
 
-GLuint Shader::getProgram() const { return shader; }
+GLuint Shader::getProgram() const { return program.get(); }
 
 // Get locations and store in a map so they can be retrieved by their name
 GLint Shader::getUniformLocation(const std::string &name) 
 {
-    return locs[name] = glGetUniformLocation(shader, name.c_str());
+    return locs[name] = glGetUniformLocation(program.get(), name.c_str());
 }
 
 GLint Shader::getAttribLocation(const std::string &name) 
 {
-    return locs[name] = glGetAttribLocation(shader, name.c_str());
+    return locs[name] = glGetAttribLocation(program.get(), name.c_str());
 }
 
 GLint Shader::getLocation(const std::string &name)
@@ -154,6 +204,16 @@ GLint Shader::getLocation(const std::string &name)
     return locs[name];
 }
 
+bool Shader::bindUniformBlock(const std::string &name, GLuint binding)
+{
+	const GLuint index = glGetUniformBlockIndex(program.get(), name.c_str());
+	if (index == GL_INVALID_INDEX)
+		return false;
+
+	glUniformBlockBinding(program.get(), index, binding);
+	return true;
+}
+
 // Set uniforms by string
 void Shader::setUniform1iv(const std::string &name, GLsizei count, const GLint *value) 
 {
@@ -5,6 +5,7 @@
 #include <map>
 #include <string>
 #include <vector>
+#include "GLResource.h"
 
 class Shader
 {
@@ -16,6 +17,7 @@ public:
     
     bool attachVertexShader(const char *vertex_file_path, const std::string &strBefore = "");
     bool attachFragmentShader(const char *fragment_file_path, const std::string &strBefore = "");
+    bool attachComputeShader(const char *compute_file_path, const std::string &strBefore = "");
     bool link();
     
 	GLuint getProgram() const;
@@ -23,6 +25,9 @@ public:
 	GLint getUniformLocation(const std::string &name);
 	GLint getAttribLocation(const std::string &name);
 	GLint getLocation(const std::string &name);
+
+	// points a uniform block at a buffer binding, false if the block is missing
+	bool bindUniformBlock(const std::string &name, GLuint binding);
     
     void setUniformMatrix3fv(const std::string &name,
                              GLsizei count,
@@ -43,13 +48,14 @@ public:
     
 protected:
     bool locExists(const std::string &name) const;
+	bool attach(GLenum stage, const char *file_path, const std::string &code);
     
     GLint Result;
     int InfoLogLength;
     
-    std::vector<GLuint> vertexShaders;
-    std::vector<GLuint> fragmentShaders;
-    GLuint shader;
+    // stage objects only live until link, whether it works or not
+    std::vector<GLShaderObject> stages;
+    GLProgram program;
     
     std::map<std::string, GLint> locs;
     
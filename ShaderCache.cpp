@@ -0,0 +1,66 @@
+#include "ShaderCache.h"
+
+#include <stdio.h>
+
+ShaderCache::ShaderCache() {}
+
+ShaderCache::~ShaderCache()
+{
+	clear();
+}
+
+Shader *ShaderCache::get(const char *vertex_file_path, const char *fragment_file_path, const std::string &defines)
+{
+	// the key is everything that goes into the program
+	const std::string key = std::string(vertex_file_path) + "|" + fragment_file_path + "|" + defines;
+
+	std::map<std::string, Shader*>::iterator found = shaders.find(key);
+	if (found != shaders.end())
+		return found->second;
+
+	Shader *shader = new Shader();
+	if (!(shader->attachVertexShader(vertex_file_path, defines) &&
+		shader->attachFragmentShader(fragment_file_path, defines) &&
+		shader->link()))
+	{
+		printf("Failed to build permutation:\n%s\n", defines.c_str());
+		delete shader;
+		return NULL;
+	}
+
+	shaders[key] = shader;
+	return shader;
+}
+
+Shader *ShaderCache::getCompute(const char *compute_file_path, const std::string &defines)
+{
+	const std::string key = std::string(compute_file_path) + "|" + defines;
+
+	std::map<std::string, Shader*>::iterator found = shaders.find(key);
+	if (found != shaders.end())
+		return found->second;
+
+	Shader *shader = new Shader();
+	if (!(shader->attachComputeShader(compute_file_path, defines) && shader->link()))
+	{
+		printf("Failed to build permutation:\n%s\n", defines.c_str());
+		delete shader;
+		return NULL;
+	}
+
+	shaders[key] = shader;
+	return shader;
+}
+
+void ShaderCache::clear()
+{
+	for (std::map<std::string, Shader*>::iterator i = shaders.begin(); i != shaders.end(); ++i)
+		delete i->second;
+
+	shaders.clear();
+}
+
+size_t ShaderCache::size() const
+{
+	return shaders.size();
+}
@@ -0,0 +1,30 @@
+#ifndef SHADERCACHE_H
+#define SHADERCACHE_H
+
+#include <map>
+#include <string>
+#include "Shader.h"
+
+// compiles shader permutations on demand and keeps them around so switching
+// between them at runtime is just a lookup
+class ShaderCache
+{
+public:
+	ShaderCache();
+	~ShaderCache();
+
+	// returns NULL if the permutation fails to compile or link
+	Shader *get(const char *vertex_file_path, const char *fragment_file_path, const std::string &defines = "");
+	Shader *getCompute(const char *compute_file_path, const std::string &defines = "");
+	void clear();
+
+	size_t size() const;
+
+private:
+	ShaderCache(const ShaderCache &);
+	ShaderCache &operator = (const ShaderCache &);
+
+	std::map<std::string, Shader*> shaders;
+};
+
+#endif
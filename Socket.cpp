@@ -0,0 +1,220 @@
+#include "Socket.h"
+
+#include <string.h>
+
+#ifdef _WIN32
+#include <ws2tcpip.h>
+#pragma comment(lib, "ws2_32.lib")
+#define INVALID_HANDLE INVALID_SOCKET
+#define closeHandle closesocket
+typedef int socklen_t;
+#else
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <signal.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#define INVALID_HANDLE -1
+#define closeHandle ::close
+#endif
+
+Socket::Socket() : handle(INVALID_HANDLE) {}
+
+Socket::~Socket()
+{
+	close();
+}
+
+bool Socket::startup()
+{
+#ifdef _WIN32
+	WSADATA data;
+	return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+#else
+	// a write to a dead peer should fail the send, not kill the process
+	signal(SIGPIPE, SIG_IGN);
+	return true;
+#endif
+}
+
+static bool makeAddress(const char *host, unsigned short port, sockaddr_in &address)
+{
+	memset(&address, 0, sizeof(address));
+	address.sin_family = AF_INET;
+	address.sin_port = htons(port);
+	return inet_pton(AF_INET, host, &address.sin_addr) == 1;
+}
+
+// small messages go out straight away, tiles are latency bound
+static void setNoDelay(SocketHandle handle)
+{
+	int flag = 1;
+	setsockopt(handle, IPPROTO_TCP, TCP_NODELAY, (const char *)&flag, sizeof(flag));
+}
+
+// spawned workers would otherwise inherit the listener and the other
+// workers' connections, and keep them open after the coordinator is gone.
+// winsock handles aren't inherited, Process::spawn doesn't ask for it
+static void setCloseOnExec(SocketHandle handle)
+{
+#ifndef _WIN32
+	fcntl(handle, F_SETFD, fcntl(handle, F_GETFD) | FD_CLOEXEC);
+#endif
+}
+
+bool Socket::listen(const char *host, unsigned short port)
+{
+	sockaddr_in address;
+	if (!makeAddress(host, port, address))
+		return false;
+
+	close();
+	if ((handle = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP)) == INVALID_HANDLE)
+		return false;
+
+	setCloseOnExec(handle);
+
+	int reuse = 1;
+	setsockopt(handle, SOL_SOCKET, SO_REUSEADDR, (const char *)&reuse, sizeof(reuse));
+
+	if (bind(handle, (sockaddr *)&address, sizeof(address)) != 0 || ::listen(handle, 16) != 0)
+	{
+		close();
+		return false;
+	}
+
+	return true;
+}
+
+bool Socket::accept(Socket &client) const
+{
+	client.close();
+	if ((client.handle = ::accept(handle, NULL, NULL)) == INVALID_HANDLE)
+		return false;
+
+	setCloseOnExec(client.handle);
+	setNoDelay(client.handle);
+	return true;
+}
+
+bool Socket::connect(const char *host, unsigned short port)
+{
+	sockaddr_in address;
+	if (!makeAddress(host, port, address))
+		return false;
+
+	close();
+	if ((handle = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP)) == INVALID_HANDLE)
+		return false;
+
+	setCloseOnExec(handle);
+
+	if (::connect(handle, (sockaddr *)&address, sizeof(address)) != 0)
+	{
+		close();
+		return false;
+	}
+
+	setNoDelay(handle);
+	return true;
+}
+
+// a peer that stops halfway through a message fails the recvAll instead of
+// hanging it
+bool Socket::setReceiveTimeout(int timeoutMs)
+{
+#ifdef _WIN32
+	DWORD timeout = timeoutMs;
+#else
+	timeval timeout;
+	timeout.tv_sec = timeoutMs / 1000;
+	timeout.tv_usec = (timeoutMs % 1000) * 1000;
+#endif
+	return setsockopt(handle, SOL_SOCKET, SO_RCVTIMEO, (const char *)&timeout, sizeof(timeout)) == 0;
+}
+
+bool Socket::sendAll(const void *data, size_t size)
+{
+	const char *bytes = (const char *)data;
+	while (size > 0)
+	{
+		const int sent = send(handle, bytes, (int)size, 0);
+		if (sent <= 0)
+			return false;
+
+		bytes += sent;
+		size -= sent;
+	}
+
+	return true;
+}
+
+bool Socket::recvAll(void *data, size_t size)
+{
+	char *bytes = (char *)data;
+	while (size > 0)
+	{
+		const int received = recv(handle, bytes, (int)size, 0);
+		if (received <= 0)
+			return false;
+
+		bytes += received;
+		size -= received;
+	}
+
+	return true;
+}
+
+void Socket::close()
+{
+	if (handle == INVALID_HANDLE)
+		return;
+
+	closeHandle(handle);
+	handle = INVALID_HANDLE;
+}
+
+bool Socket::isOpen() const
+{
+	return handle != INVALID_HANDLE;
+}
+
+unsigned short Socket::getPort() const
+{
+	sockaddr_in address;
+	socklen_t length = sizeof(address);
+	if (getsockname(handle, (sockaddr *)&address, &length) != 0)
+		return 0;
+
+	return ntohs(address.sin_port);
+}
+
+int Socket::select(const std::vector<Socket*> &sockets, std::vector<bool> &readable, int timeoutMs)
+{
+	fd_set set;
+	FD_ZERO(&set);
+
+	SocketHandle highest = 0;
+	for (size_t i = 0; i < sockets.size(); ++i)
+	{
+		FD_SET(sockets[i]->handle, &set);
+		if (sockets[i]->handle > highest)
+			highest = sockets[i]->handle;
+	}
+
+	timeval timeout;
+	timeout.tv_sec = timeoutMs / 1000;
+	timeout.tv_usec = (timeoutMs % 1000) * 1000;
+
+	// the first argument is ignored by winsock
+	const int count = ::select((int)highest + 1, &set, NULL, NULL, &timeout);
+
+	readable.assign(sockets.size(), false);
+	for (size_t i = 0; i < sockets.size() && count > 0; ++i)
+		readable[i] = FD_ISSET(sockets[i]->handle, &set) != 0;
+
+	return count > 0 ? count : 0;
+}
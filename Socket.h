@@ -0,0 +1,49 @@
+#ifndef SOCKET_H
+#define SOCKET_H
+
+#include <stddef.h>
+#include <vector>
+
+#ifdef _WIN32
+#include <winsock2.h>
+typedef SOCKET SocketHandle;
+#else
+typedef int SocketHandle;
+#endif
+
+// blocking tcp socket, just enough for the render farm
+class Socket
+{
+public:
+	Socket();
+	~Socket();
+
+	// winsock needs initializing once per process
+	static bool startup();
+
+	bool listen(const char *host, unsigned short port);
+	bool accept(Socket &client) const;
+	bool connect(const char *host, unsigned short port);
+
+	// 0 blocks for as long as it takes
+	bool setReceiveTimeout(int timeoutMs);
+
+	bool sendAll(const void *data, size_t size);
+	bool recvAll(void *data, size_t size);
+
+	void close();
+	bool isOpen() const;
+	unsigned short getPort() const;
+
+	// waits up to timeoutMs for any of the sockets to become readable,
+	// returns the number that are
+	static int select(const std::vector<Socket*> &sockets, std::vector<bool> &readable, int timeoutMs);
+
+private:
+	Socket(const Socket &);
+	Socket &operator = (const Socket &);
+
+	SocketHandle handle;
+};
+
+#endif
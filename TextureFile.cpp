@@ -0,0 +1,190 @@
+#include "TextureFile.h"
+
+#include <algorithm>
+#include <stdio.h>
+#include <string.h>
+
+TextureFile::TextureFile() : data(NULL), header(NULL), levels(NULL) {}
+
+bool TextureFile::parse(const unsigned char *data, size_t size)
+{
+	this->data = NULL;
+	if (!data || size < sizeof(TextureFileHeader))
+		return false;
+
+	const TextureFileHeader *header = (const TextureFileHeader *)data;
+	if (memcmp(header->magic, "GTEX", 4) != 0 || header->version != TEXTURE_FILE_VERSION ||
+		header->width == 0 || header->height == 0 || header->tile == 0 || header->levels == 0 || header->levels > 32 ||
+		size < sizeof(TextureFileHeader) + header->levels * sizeof(TextureFileLevel))
+		return false;
+
+	const TextureFileLevel *levels = (const TextureFileLevel *)(data + sizeof(TextureFileHeader));
+
+	// every level has to be where it says and hold exactly its pixels
+	uint32_t width = header->width, height = header->height;
+	for (uint32_t i = 0; i < header->levels; ++i)
+	{
+		const TextureFileLevel &level = levels[i];
+		if (level.width != width || level.height != height || level.size != (uint64_t)width * height * 4 ||
+			level.offset > size || level.size > size - level.offset)
+			return false;
+
+		width = std::max(1u, width / 2);
+		height = std::max(1u, height / 2);
+	}
+
+	this->data = data;
+	this->header = header;
+	this->levels = levels;
+	return true;
+}
+
+const TextureFileHeader &TextureFile::getHeader() const
+{
+	return *header;
+}
+
+const TextureFileLevel &TextureFile::getLevel(int level) const
+{
+	return levels[level];
+}
+
+int TextureFile::getLevelCount() const
+{
+	return data ? (int)header->levels : 0;
+}
+
+int TextureFile::getTileRows(int level) const
+{
+	return (int)((levels[level].height + header->tile - 1) / header->tile);
+}
+
+int TextureFile::getRowsInTileRow(int level, int tileRow) const
+{
+	return (int)std::min(header->tile, levels[level].height - tileRow * header->tile);
+}
+
+void TextureFile::decodeTileRow(int level, int tileRow, unsigned char *rgba) const
+{
+	const TextureFileLevel &info = levels[level];
+	const int tile = (int)header->tile;
+	const int width = (int)info.width;
+	const int rows = getRowsInTileRow(level, tileRow);
+
+	// full rows of tiles above this one hold tile * width pixels each
+	const unsigned char *source = data + info.offset + (size_t)tileRow * tile * width * 4;
+
+	for (int x = 0; x < width; x += tile)
+	{
+		const int tileWidth = std::min(tile, width - x);
+		for (int y = 0; y < rows; ++y)
+		{
+			memcpy(rgba + ((size_t)y * width + x) * 4, source, tileWidth * 4);
+			source += tileWidth * 4;
+		}
+	}
+}
+
+// 2x2 box filter, odd edges repeat their last pixel
+static void downsample(const std::vector<unsigned char> &source, int width, int height, std::vector<unsigned char> &result)
+{
+	const int w = std::max(1, width / 2), h = std::max(1, height / 2);
+	result.resize((size_t)w * h * 4);
+
+	for (int y = 0; y < h; ++y)
+	{
+		const int y0 = std::min(y * 2, height - 1), y1 = std::min(y * 2 + 1, height - 1);
+		for (int x = 0; x < w; ++x)
+		{
+			const int x0 = std::min(x * 2, width - 1), x1 = std::min(x * 2 + 1, width - 1);
+			for (int c = 0; c < 4; ++c)
+			{
+				const int sum = source[((size_t)y0 * width + x0) * 4 + c] + source[((size_t)y0 * width + x1) * 4 + c] +
+					source[((size_t)y1 * width + x0) * 4 + c] + source[((size_t)y1 * width + x1) * 4 + c];
+				result[((size_t)y * w + x) * 4 + c] = (unsigned char)((sum + 2) / 4);
+			}
+		}
+	}
+}
+
+// the inverse of decodeTileRow over a whole level
+static void encodeTiles(const std::vector<unsigned char> &rgba, int width, int height, int tile, std::vector<unsigned char> &tiled)
+{
+	tiled.resize(rgba.size());
+	unsigned char *target = tiled.empty() ? NULL : &tiled[0];
+
+	for (int ty = 0; ty < height; ty += tile)
+	{
+		const int rows = std::min(tile, height - ty);
+		for (int x = 0; x < width; x += tile)
+		{
+			const int tileWidth = std::min(tile, width - x);
+			for (int y = 0; y < rows; ++y)
+			{
+				memcpy(target, &rgba[((size_t)(ty + y) * width + x) * 4], tileWidth * 4);
+				target += tileWidth * 4;
+			}
+		}
+	}
+}
+
+bool TextureFile::write(const char *path, const std::vector<unsigned char> &rgba, int width, int height, int tile)
+{
+	if (width <= 0 || height <= 0 || tile <= 0 || rgba.size() != (size_t)width * height * 4)
+		return false;
+
+	TextureFileHeader header;
+	memcpy(header.magic, "GTEX", 4);
+	header.version = TEXTURE_FILE_VERSION;
+	header.width = width;
+	header.height = height;
+	header.tile = tile;
+	header.levels = 1;
+	for (int size = std::max(width, height); size > 1; size /= 2)
+		++header.levels;
+
+	std::vector<TextureFileLevel> levels(header.levels);
+	uint64_t offset = sizeof(TextureFileHeader) + header.levels * sizeof(TextureFileLevel);
+
+	FILE *file = fopen(path, "wb");
+	if (!file)
+	{
+		printf("Failed to open %s for writing!\n", path);
+		return false;
+	}
+
+	// the table goes in front once the level sizes are known
+	fseek(file, (long)offset, SEEK_SET);
+
+	std::vector<unsigned char> level = rgba, next, tiled;
+	int w = width, h = height;
+	bool success = true;
+
+	for (uint32_t i = 0; i < header.levels && success; ++i)
+	{
+		levels[i].width = w;
+		levels[i].height = h;
+		levels[i].offset = offset;
+		levels[i].size = (uint64_t)w * h * 4;
+
+		encodeTiles(level, w, h, tile, tiled);
+		success = fwrite(&tiled[0], 1, tiled.size(), file) == tiled.size();
+		offset += levels[i].size;
+
+		downsample(level, w, h, next);
+		level.swap(next);
+		w = std::max(1, w / 2);
+		h = std::max(1, h / 2);
+	}
+
+	fseek(file, 0, SEEK_SET);
+	success = success && fwrite(&header, sizeof(header), 1, file) == 1 &&
+		fwrite(&levels[0], sizeof(TextureFileLevel), levels.size(), file) == levels.size();
+
+	fclose(file);
+
+	if (!success)
+		printf("Failed to write %s!\n", path);
+
+	return success;
+}
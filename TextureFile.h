@@ -0,0 +1,63 @@
+#ifndef TEXTUREFILE_H
+#define TEXTUREFILE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#define TEXTURE_FILE_VERSION 1
+#define TEXTURE_FILE_TILE 64	// tile edge in pixels written by --make-texture
+
+// .gtex, a texture laid out for streaming. a header, one entry per mip level
+// and the levels themselves, rgba8 and ready for glTexSubImage2D once the
+// tiles are put back in rows. every level is stored as rows of tiles, each
+// tile tile x tile pixels (smaller along the right and top edges) with its
+// own rows one after the other, so a row of tiles is one contiguous range
+// of the file and a chunk of a level needs only that range paged in
+struct TextureFileHeader
+{
+	char magic[4];		// "GTEX"
+	uint32_t version;
+	uint32_t width, height;
+	uint32_t levels;	// full chain down to 1x1
+	uint32_t tile;
+};
+
+struct TextureFileLevel
+{
+	uint32_t width, height;
+	uint64_t offset;	// from the start of the file
+	uint64_t size;
+};
+
+// a validated view of a mapped .gtex
+class TextureFile
+{
+public:
+	TextureFile();
+
+	// false if data isn't a complete .gtex, nothing is copied
+	bool parse(const unsigned char *data, size_t size);
+
+	const TextureFileHeader &getHeader() const;
+	const TextureFileLevel &getLevel(int level) const;
+	int getLevelCount() const;
+
+	// tile rows in a level and the pixel rows one of them covers
+	int getTileRows(int level) const;
+	int getRowsInTileRow(int level, int tileRow) const;
+
+	// untiles one row of tiles into width * rows rgba pixels, safe to call
+	// from any thread
+	void decodeTileRow(int level, int tileRow, unsigned char *rgba) const;
+
+	// builds the mip chain with a box filter and writes it tiled
+	static bool write(const char *path, const std::vector<unsigned char> &rgba, int width, int height, int tile);
+
+private:
+	const unsigned char *data;
+	const TextureFileHeader *header;
+	const TextureFileLevel *levels;
+};
+
+#endif
@@ -0,0 +1,395 @@
+#include "TextureStreamer.h"
+
+#include <GLFW/glfw3.h>
+#include <algorithm>
+#include <stdint.h>
+#include <stdio.h>
+
+StreamedTexture::StreamedTexture()
+	: baseLevel(0), nextLevel(-1), nextTileRow(0), requested(0.0), placeholderAt(0.0), residentAt(0.0),
+	frames(0), bytes(0) {}
+
+TextureStreamer::Buffer::Buffer() : fence(0), busy(false) {}
+
+TextureStreamer::TextureStreamer()
+	: budget(STREAM_DEFAULT_BUDGET * 1024), updates(0), streamingFrames(0), idleFrames(0),
+	streamingMs(0.0), idleMs(0.0), worstStreamingMs(0.0), worstIdleMs(0.0), updateMs(0.0), worstUpdateMs(0.0),
+	totalBytes(0), worstFrameBytes(0), streamedLastFrame(false) {}
+
+TextureStreamer::~TextureStreamer()
+{
+	release();
+}
+
+void TextureStreamer::setBudget(size_t bytes)
+{
+	budget = bytes;
+}
+
+StreamedTexture *TextureStreamer::load(const char *path)
+{
+	StreamedTexture *texture = new StreamedTexture();
+	texture->path = path;
+	texture->requested = glfwGetTime();
+
+	if (!texture->file.open(path) || !texture->format.parse(texture->file.getData(), texture->file.getSize()))
+	{
+		printf("Failed to load texture %s!\n", path);
+		delete texture;
+		return NULL;
+	}
+
+	const TextureFile &format = texture->format;
+	const int levels = format.getLevelCount();
+
+	// every level exists from the start, the base level hides the ones
+	// that are still on their way
+	texture->texture.create();
+	glBindTexture(GL_TEXTURE_2D, texture->texture.get());
+	for (int i = 0; i < levels; ++i)
+		glTexImage2D(GL_TEXTURE_2D, i, GL_RGBA8, format.getLevel(i).width, format.getLevel(i).height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1);
+	texture->texture.setBytes(textureBytes(GL_RGBA8, format.getHeader().width, format.getHeader().height, levels));
+
+	// the small end of the chain is a few KB, it goes up right away so there
+	// is something to sample
+	texture->rowsPending.resize(levels);
+	std::vector<unsigned char> rgba;
+	int level = levels - 1;
+
+	for (; level >= 0; --level)
+	{
+		const TextureFileLevel &info = format.getLevel(level);
+		if (std::max(info.width, info.height) > STREAM_PLACEHOLDER_SIZE)
+			break;
+
+		rgba.resize((size_t)info.width * info.height * 4);
+		for (int row = 0; row < format.getTileRows(level); ++row)
+			format.decodeTileRow(level, row, &rgba[(size_t)row * format.getHeader().tile * info.width * 4]);
+
+		glTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, info.width, info.height, GL_RGBA, GL_UNSIGNED_BYTE, &rgba[0]);
+		texture->bytes += rgba.size();
+	}
+
+	texture->baseLevel = level + 1;
+	texture->nextLevel = level;
+	for (int i = 0; i <= level; ++i)
+		texture->rowsPending[i] = format.getTileRows(i);
+
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, texture->baseLevel);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	texture->placeholderAt = glfwGetTime();
+	if (texture->baseLevel == 0)
+		texture->residentAt = texture->placeholderAt;
+
+	printf("Texture %s: %ux%u, %d levels, %.2f MB\n", path, format.getHeader().width, format.getHeader().height, levels,
+		texture->texture.getBytes() / 1048576.0);
+
+	textures.push_back(texture);
+	return texture;
+}
+
+// a free buffer of at least bytes whose last copy has finished, -1 if there
+// is none. wait blocks on the copy instead
+int TextureStreamer::acquireBuffer(size_t bytes, bool wait)
+{
+	for (int i = 0; i < STREAM_BUFFERS; ++i)
+	{
+		Buffer &buffer = buffers[i];
+		if (buffer.busy)
+			continue;
+
+		if (buffer.fence)
+		{
+			if (glClientWaitSync(buffer.fence, GL_SYNC_FLUSH_COMMANDS_BIT, wait ? GL_TIMEOUT_IGNORED : 0) == GL_TIMEOUT_EXPIRED)
+				continue;
+
+			glDeleteSync(buffer.fence);
+			buffer.fence = 0;
+		}
+
+		if (!buffer.buffer.get())
+			buffer.buffer.create();
+
+		if (buffer.buffer.getBytes() < bytes)
+		{
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer.buffer.get());
+			glBufferData(GL_PIXEL_UNPACK_BUFFER, bytes, NULL, GL_STREAM_DRAW);
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+			buffer.buffer.setBytes(bytes);
+		}
+
+		buffer.busy = true;
+		return i;
+	}
+
+	return -1;
+}
+
+// hands the texture's next rows of tiles to the job system until the budget
+// or the buffers run out. one row always goes if nothing else has this
+// frame, so a budget below a row still makes progress
+bool TextureStreamer::schedule(StreamedTexture &texture, size_t &remaining, bool &scheduled, bool wait)
+{
+	const TextureFile &format = texture.format;
+
+	while (texture.nextLevel >= 0)
+	{
+		const int level = texture.nextLevel, tileRow = texture.nextTileRow;
+		const int width = (int)format.getLevel(level).width;
+		const int rows = format.getRowsInTileRow(level, tileRow);
+		const size_t bytes = (size_t)width * rows * 4;
+
+		if (bytes > remaining && scheduled)
+			return false;
+
+		const int buffer = acquireBuffer(bytes, wait);
+		if (buffer < 0)
+			return false;
+
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffers[buffer].buffer.get());
+		void *mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, bytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+		if (!mapped)
+		{
+			printf("Failed to map a texture upload buffer!\n");
+			buffers[buffer].busy = false;
+			return false;
+		}
+
+		Upload *upload = new Upload();
+		upload->texture = &texture;
+		upload->level = level;
+		upload->tileRow = tileRow;
+		upload->y = tileRow * (int)format.getHeader().tile;
+		upload->rows = rows;
+		upload->bytes = bytes;
+		upload->buffer = buffer;
+		upload->mapped = mapped;
+
+		// the worker reads the mapping, so the page faults land there too
+		const TextureFile *source = &format;
+		unsigned char *target = (unsigned char *)mapped;
+		upload->job.setWork([=]() { source->decodeTileRow(level, tileRow, target); });
+		JobSystem::getInstance().submit(upload->job);
+		uploads.push_back(upload);
+
+		if (++texture.nextTileRow == format.getTileRows(level))
+		{
+			--texture.nextLevel;
+			texture.nextTileRow = 0;
+		}
+
+		remaining -= std::min(bytes, remaining);
+		scheduled = true;
+	}
+
+	return true;
+}
+
+// copies a decoded row out of its buffer into the texture, the job is done
+void TextureStreamer::finish(Upload &upload)
+{
+	StreamedTexture &texture = *upload.texture;
+	Buffer &buffer = buffers[upload.buffer];
+
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer.buffer.get());
+	if (!glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER))
+		printf("Texture upload buffer was lost, %s level %d may show garbage!\n", texture.path.c_str(), upload.level);
+
+	glBindTexture(GL_TEXTURE_2D, texture.texture.get());
+	glTexSubImage2D(GL_TEXTURE_2D, upload.level, 0, upload.y, texture.format.getLevel(upload.level).width, upload.rows,
+		GL_RGBA, GL_UNSIGNED_BYTE, (const GLvoid *)0);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+	buffer.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	buffer.busy = false;
+
+	texture.bytes += upload.bytes;
+	--texture.rowsPending[upload.level];
+
+	// the base level follows the complete levels down
+	const int baseLevel = texture.baseLevel;
+	while (texture.baseLevel > 0 && texture.rowsPending[texture.baseLevel - 1] == 0)
+		--texture.baseLevel;
+
+	if (texture.baseLevel != baseLevel)
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, texture.baseLevel);
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	if (texture.baseLevel == 0 && texture.residentAt == 0.0)
+		texture.residentAt = glfwGetTime();
+}
+
+void TextureStreamer::update(double frameMs)
+{
+	// the last frame counts as streaming if work was in flight during it
+	if (frameMs > 0.0)
+	{
+		if (streamedLastFrame)
+		{
+			++streamingFrames;
+			streamingMs += frameMs;
+			worstStreamingMs = std::max(worstStreamingMs, frameMs);
+		}
+		else
+		{
+			++idleFrames;
+			idleMs += frameMs;
+			worstIdleMs = std::max(worstIdleMs, frameMs);
+		}
+	}
+
+	if (!isStreaming())
+	{
+		streamedLastFrame = false;
+		return;
+	}
+
+	const double start = glfwGetTime();
+	JobSystem &jobs = JobSystem::getInstance();
+	size_t frameBytes = 0;
+
+	for (std::vector<StreamedTexture*>::iterator i = textures.begin(); i != textures.end(); ++i)
+		if ((*i)->residentAt == 0.0)
+			++(*i)->frames;
+
+	if (budget == 0)
+	{
+		// the naive load, everything before the frame goes on
+		while (isStreaming())
+		{
+			size_t remaining = SIZE_MAX;
+			bool scheduled = false;
+			for (std::vector<StreamedTexture*>::iterator i = textures.begin(); i != textures.end(); ++i)
+				if (!schedule(**i, remaining, scheduled, true))
+					break;
+
+			for (std::deque<Upload*>::iterator i = uploads.begin(); i != uploads.end(); ++i)
+			{
+				jobs.wait((*i)->job);
+				finish(**i);
+				frameBytes += (*i)->bytes;
+				delete *i;
+			}
+
+			uploads.clear();
+		}
+	}
+	else
+	{
+		for (std::deque<Upload*>::iterator i = uploads.begin(); i != uploads.end();)
+		{
+			if (!(*i)->job.isDone())
+			{
+				++i;
+				continue;
+			}
+
+			finish(**i);
+			frameBytes += (*i)->bytes;
+			delete *i;
+			i = uploads.erase(i);
+		}
+
+		size_t remaining = budget;
+		bool scheduled = false;
+		for (std::vector<StreamedTexture*>::iterator i = textures.begin(); i != textures.end(); ++i)
+			if (!schedule(**i, remaining, scheduled, false))
+				break;
+
+		// without worker threads nobody else runs the decodes, they are
+		// within the budget so they happen here and get copied next frame
+		if (jobs.getThreadCount() <= 1)
+			for (std::deque<Upload*>::iterator i = uploads.begin(); i != uploads.end(); ++i)
+				jobs.wait((*i)->job);
+	}
+
+	++updates;
+	totalBytes += frameBytes;
+	worstFrameBytes = std::max(worstFrameBytes, frameBytes);
+	streamedLastFrame = true;
+
+	const double ms = (glfwGetTime() - start) * 1000.0;
+	updateMs += ms;
+	worstUpdateMs = std::max(worstUpdateMs, ms);
+}
+
+bool TextureStreamer::isStreaming() const
+{
+	if (!uploads.empty())
+		return true;
+
+	for (std::vector<StreamedTexture*>::const_iterator i = textures.begin(); i != textures.end(); ++i)
+		if ((*i)->nextLevel >= 0)
+			return true;
+
+	return false;
+}
+
+// needs the context, in flight decodes are waited for
+void TextureStreamer::release()
+{
+	JobSystem &jobs = JobSystem::getInstance();
+	for (std::deque<Upload*>::iterator i = uploads.begin(); i != uploads.end(); ++i)
+	{
+		jobs.wait((*i)->job);
+
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffers[(*i)->buffer].buffer.get());
+		glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		delete *i;
+	}
+
+	uploads.clear();
+
+	for (std::vector<StreamedTexture*>::iterator i = textures.begin(); i != textures.end(); ++i)
+		delete *i;
+
+	textures.clear();
+
+	for (int i = 0; i < STREAM_BUFFERS; ++i)
+	{
+		if (buffers[i].fence)
+			glDeleteSync(buffers[i].fence);
+
+		buffers[i].fence = 0;
+		buffers[i].busy = false;
+		buffers[i].buffer.reset();
+	}
+}
+
+void TextureStreamer::report() const
+{
+	if (budget)
+		printf("Texture streaming: %u KB per frame budget, %d buffers\n", (unsigned int)(budget / 1024), STREAM_BUFFERS);
+	else
+		printf("Texture streaming: synchronous\n");
+
+	printf("%-24s %12s %8s %10s %15s %12s %8s\n", "texture", "size", "levels", "MB", "placeholder ms", "resident ms", "frames");
+	for (std::vector<StreamedTexture*>::const_iterator i = textures.begin(); i != textures.end(); ++i)
+	{
+		const StreamedTexture &texture = **i;
+		char size[32], resident[32];
+		sprintf(size, "%ux%u", texture.format.getHeader().width, texture.format.getHeader().height);
+		sprintf(resident, texture.residentAt > 0.0 ? "%.1f" : "-", (texture.residentAt - texture.requested) * 1000.0);
+
+		printf("%-24s %12s %8d %10.2f %15.1f %12s %8d\n", texture.path.c_str(), size, texture.format.getLevelCount(),
+			texture.bytes / 1048576.0, (texture.placeholderAt - texture.requested) * 1000.0, resident, texture.frames);
+	}
+
+	printf("Uploads: %.1f KB per streaming frame, %.1f KB worst\n",
+		updates > 0 ? totalBytes / 1024.0 / updates : 0.0, worstFrameBytes / 1024.0);
+	printf("Update: %.3f ms per streaming frame, %.3f ms worst\n", updates > 0 ? updateMs / updates : 0.0, worstUpdateMs);
+	printf("Frames: %.2f ms average, %.2f ms worst over %d while streaming, %.2f ms average, %.2f ms worst over %d after\n",
+		streamingFrames > 0 ? streamingMs / streamingFrames : 0.0, worstStreamingMs, streamingFrames,
+		idleFrames > 0 ? idleMs / idleFrames : 0.0, worstIdleMs, idleFrames);
+}
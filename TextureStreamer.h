@@ -0,0 +1,103 @@
+#ifndef TEXTURESTREAMER_H
+#define TEXTURESTREAMER_H
+
+#include <GL/glew.h>
+#include <deque>
+#include <string>
+#include <vector>
+#include "GLResource.h"
+#include "JobSystem.h"
+#include "MappedFile.h"
+#include "TextureFile.h"
+
+#define STREAM_DEFAULT_BUDGET 1024	// KB uploaded per frame unless --texture-budget says otherwise
+#define STREAM_PLACEHOLDER_SIZE 16	// mips this size and smaller go up synchronously at load
+#define STREAM_BUFFERS 8			// pixel unpack buffers cycled through by the uploads
+
+// a texture being streamed in. levels arrive coarsest first and the base
+// level follows them down, so it can be sampled from the moment it is loaded
+struct StreamedTexture
+{
+	StreamedTexture();
+
+	std::string path;
+	MappedFile file;
+	TextureFile format;
+	GLTexture texture;
+
+	int baseLevel;					// finest level that is complete, and every coarser one
+	std::vector<int> rowsPending;	// tile rows per level not yet uploaded
+	int nextLevel, nextTileRow;		// next chunk to schedule
+
+	double requested, placeholderAt, residentAt;
+	int frames;						// frames it took to become resident
+	size_t bytes;
+};
+
+// loads .gtex files without stalling the frame. the file is mapped, each row
+// of tiles is untiled by a job straight into a mapped pixel unpack buffer,
+// and the main thread copies finished rows into the texture from there. a
+// byte budget caps what gets scheduled per frame. a budget of 0 loads the
+// whole texture inside update(), the naive way, for comparison
+class TextureStreamer
+{
+public:
+	TextureStreamer();
+	~TextureStreamer();
+
+	void setBudget(size_t bytes);
+
+	// maps the file and makes the placeholder mips resident, NULL on failure
+	StreamedTexture *load(const char *path);
+
+	// once per frame on the thread that owns the context, frameMs is the time
+	// of the last frame so its cost can be told apart from idle frames
+	void update(double frameMs);
+
+	bool isStreaming() const;
+
+	void release();
+	void report() const;
+
+private:
+	TextureStreamer(const TextureStreamer &);
+	TextureStreamer &operator = (const TextureStreamer &);
+
+	// one row of tiles on its way from the file to the texture
+	struct Upload
+	{
+		StreamedTexture *texture;
+		int level, tileRow, y, rows;
+		size_t bytes;
+		int buffer;
+		void *mapped;
+		Job job;
+	};
+
+	struct Buffer
+	{
+		Buffer();
+
+		GLBuffer buffer;
+		GLsync fence;		// the last copy out of it
+		bool busy;
+	};
+
+	bool schedule(StreamedTexture &texture, size_t &remaining, bool &scheduled, bool wait);
+	int acquireBuffer(size_t bytes, bool wait);
+	void finish(Upload &upload);
+
+	size_t budget;
+	std::vector<StreamedTexture*> textures;
+	std::deque<Upload*> uploads;
+	Buffer buffers[STREAM_BUFFERS];
+
+	// frame costs while something was in flight and after
+	int updates, streamingFrames, idleFrames;
+	double streamingMs, idleMs, worstStreamingMs, worstIdleMs;
+	double updateMs, worstUpdateMs;
+	size_t totalBytes, worstFrameBytes;
+	bool streamedLastFrame;
+};
+
+#endif
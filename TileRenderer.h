@@ -0,0 +1,26 @@
+#ifndef TILERENDERER_H
+#define TILERENDERER_H
+
+// one tile of one frame of a render farm sequence. rows are stored bottom
+// up, like glReadPixels returns them
+struct TileJob
+{
+	unsigned int id;
+	unsigned int frame;
+	float time;
+	unsigned int tier;
+	unsigned int width, height;	// whole frame
+	unsigned int x, y, w, h;	// the tile
+};
+
+// what a render farm worker renders tiles with
+class TileRenderer
+{
+public:
+	virtual ~TileRenderer() {}
+
+	// writes job.w * job.h rgb8 pixels
+	virtual bool renderTile(const TileJob &job, unsigned char *rgb) = 0;
+};
+
+#endif
@@ -1,40 +1,30 @@
 #ifndef VEC2_H
 #define VEC2_H
 
+#include <type_traits>
+
+// plain members and no user-provided copy or assignment, so it stays
+// trivially copyable and usable in constant expressions
 template <class T>
 class Vec2
 {
 public:
-	Vec2();
-	Vec2(float cX, float cY);
-
-	Vec2<T> &operator = (const Vec2<T> &rhs);
-
-	union
-	{
-		struct
-		{
-			float x, y;
-		};
-		float v[2];
-	};
-};
+	typedef T Component;
+	enum { components = 2 };
 
-typedef Vec2<float> Vec2f; // basic 2-float vector
+	Vec2() = default;
+	constexpr Vec2(T cX, T cY);
 
-template <class T>
-Vec2<T>::Vec2() {};
+	T x, y;
+};
 
-template <class T>
-Vec2<T>::Vec2(float cX, float cY) :x(cX), y(cY) {}
+typedef Vec2<float> Vec2f; // basic 2-float vector
 
 template <class T>
-Vec2<T> &Vec2<T>::operator = (const Vec2<T> &rhs)
-{
-	x = rhs.x;
-	y = rhs.y;
+constexpr Vec2<T>::Vec2(T cX, T cY) : x(cX), y(cY) {}
 
-	return *this;
-}
+static_assert(std::is_trivially_copyable<Vec2f>::value, "Vec2f must be trivially copyable");
+static_assert(sizeof(Vec2f) == 2 * sizeof(float), "Vec2f must be tightly packed");
+static_assert(Vec2f(1.0f, 2.0f).y == 2.0f, "Vec2f must be constexpr");
 
 #endif
\ No newline at end of file
@@ -1,91 +1,86 @@
 #ifndef VEC3_H
 #define VEC3_H
 
+#include <math.h>
+#include <type_traits>
+
+// plain members and no user-provided copy or assignment, so it stays
+// trivially copyable and usable in constant expressions
 template <class T>
 class Vec3
 {
 public:
-	Vec3();
-	Vec3(T cX, T cY, T cZ);
-
-	Vec3<T> &operator = (const Vec3<T> &rhs);
-	Vec3<T> operator - (const Vec3<T> &rhs) const;
-	Vec3<T> operator / (const float rhs) const;
-	Vec3<T> operator + (const float rhs) const;
-	Vec3<T> operator * (const float rhs) const;
-	friend Vec3<T> operator * (const float a, const Vec3<T> &b);
-
-	static T dotProduct(const Vec3<T> &a, const Vec3<T> &b);
-	static Vec3<T> crossProduct(const Vec3<T> &a, const Vec3<T> &b);
+	typedef T Component;
+	enum { components = 3 };
+
+	Vec3() = default;
+	constexpr Vec3(T cX, T cY, T cZ);
+
+	constexpr Vec3<T> operator + (const Vec3<T> &rhs) const;
+	constexpr Vec3<T> operator - (const Vec3<T> &rhs) const;
+	constexpr Vec3<T> operator / (const float rhs) const;
+	constexpr Vec3<T> operator + (const float rhs) const;
+	constexpr Vec3<T> operator * (const float rhs) const;
+
+	static constexpr T dotProduct(const Vec3<T> &a, const Vec3<T> &b);
+	static constexpr Vec3<T> crossProduct(const Vec3<T> &a, const Vec3<T> &b);
+
+	// sqrt isn't constexpr, these two are runtime only
 	static T length(const Vec3<T> &rhs);
 	static Vec3<T> normalize(const Vec3<T> &rhs);
 
-	union
-	{
-		struct
-		{
-			T x, y, z;
-		};
-		T v[3];
-	};
+	T x, y, z;
 };
 
 typedef Vec3<float> Vec3f; // basic 3-float vector
 
 template <class T>
-Vec3<T>::Vec3() {}
+constexpr Vec3<T>::Vec3(T cX, T cY, T cZ) : x(cX), y(cY), z(cZ) {}
 
 template <class T>
-Vec3<T>::Vec3(T cX, T cY, T cZ) :x(cX), y(cY), z(cZ) {}
-
-template <class T>
-Vec3<T> &Vec3<T>::operator = (const Vec3<T> &rhs)
+constexpr Vec3<T> Vec3<T>::operator + (const Vec3<T> &rhs) const
 {
-	x = rhs.x;
-	y = rhs.y;
-	z = rhs.z;
-
-	return *this;
+	return Vec3<T>(x + rhs.x, y + rhs.y, z + rhs.z);
 }
 
 template <class T>
-Vec3<T> Vec3<T>::operator - (const Vec3<T> &rhs) const
+constexpr Vec3<T> Vec3<T>::operator - (const Vec3<T> &rhs) const
 {
 	return Vec3<T>(x - rhs.x, y - rhs.y, z - rhs.z);
 }
 
 template <class T>
-Vec3<T> Vec3<T>::operator / (float rhs) const
+constexpr Vec3<T> Vec3<T>::operator / (float rhs) const
 {
 	return Vec3<T>(x / rhs, y / rhs, z / rhs);
 }
 
 template <class T>
-Vec3<T> Vec3<T>::operator * (const float rhs) const
+constexpr Vec3<T> Vec3<T>::operator * (const float rhs) const
 {
 	return Vec3<T>(x * rhs, y * rhs, z * rhs);
 }
 
 template <class T>
-Vec3<T> Vec3<T>::operator + (const float rhs) const
+constexpr Vec3<T> Vec3<T>::operator + (const float rhs) const
 {
 	return Vec3<T>(x + rhs, y + rhs, z + rhs);
 }
 
 template <class T>
-Vec3<T> operator * (const float a, const Vec3<T> &b)
+constexpr Vec3<T> operator * (const float a, const Vec3<T> &b)
 {
 	return Vec3<T>(a * b.x, a * b.y, a * b.z);
 }
 
 template <class T>
-T Vec3<T>::dotProduct(const Vec3<T> &a, const Vec3<T> &b)
+constexpr T Vec3<T>::dotProduct(const Vec3<T> &a, const Vec3<T> &b)
 {
 	return a.x * b.x + a.y * b.y + a.z * b.z;
 }
 
 template <class T>
-Vec3<T> Vec3<T>::crossProduct(const Vec3<T> &a, const Vec3<T> &b)
+constexpr Vec3<T> Vec3<T>::crossProduct(const Vec3<T> &a, const Vec3<T> &b)
 {
 	return Vec3<T>(a.y * b.z - a.z * b.y,
 		a.z * b.x - a.x * b.z,
@@ -104,4 +99,9 @@ Vec3<T> Vec3<T>::normalize(const Vec3<T> &rhs)
 	return rhs / length(rhs);
 }
 
+static_assert(std::is_trivially_copyable<Vec3f>::value, "Vec3f must be trivially copyable");
+static_assert(sizeof(Vec3f) == 3 * sizeof(float), "Vec3f must be tightly packed");
+static_assert(Vec3f::crossProduct(Vec3f(1.0f, 0.0f, 0.0f), Vec3f(0.0f, 1.0f, 0.0f)).z == 1.0f, "Vec3f must be constexpr");
+static_assert(Vec3f::dotProduct(Vec3f(1.0f, 2.0f, 3.0f), 2.0f * Vec3f(1.0f, 1.0f, 1.0f)) == 12.0f, "Vec3f must be constexpr");
+
 #endif
\ No newline at end of file
@@ -0,0 +1,157 @@
+#ifndef VERTEXFORMAT_H
+#define VERTEXFORMAT_H
+
+#include <GL/glew.h>
+#include <limits>
+#include <stddef.h>
+#include "Half.h"
+#include "Vec2.h"
+#include "Vec3.h"
+
+typedef Vec2<Half> Vec2h;
+typedef Vec3<Half> Vec3h;
+
+// gl type of a vector component. integers are always normalized, a compact
+// attribute is a fixed point stand-in for a float one
+template <class T> struct GLComponent;
+template <> struct GLComponent<float> { enum { type = GL_FLOAT, normalized = GL_FALSE }; };
+template <> struct GLComponent<Half> { enum { type = GL_HALF_FLOAT, normalized = GL_FALSE }; };
+template <> struct GLComponent<short> { enum { type = GL_SHORT, normalized = GL_TRUE }; };
+template <> struct GLComponent<unsigned short> { enum { type = GL_UNSIGNED_SHORT, normalized = GL_TRUE }; };
+template <> struct GLComponent<signed char> { enum { type = GL_BYTE, normalized = GL_TRUE }; };
+template <> struct GLComponent<unsigned char> { enum { type = GL_UNSIGNED_BYTE, normalized = GL_TRUE }; };
+
+// float to the normalized integer the gpu turns back into it, [0, 1] for
+// unsigned and [-1, 1] for signed types
+template <class T>
+T packNormalized(float value)
+{
+	const float lowest = std::numeric_limits<T>::is_signed ? -1.0f : 0.0f;
+	value = value < lowest ? lowest : (value > 1.0f ? 1.0f : value);
+
+	const float scaled = value * std::numeric_limits<T>::max();
+	return (T)(scaled < 0.0f ? scaled - 0.5f : scaled + 0.5f);
+}
+
+// one attribute padded to 4 bytes, gl wants every attribute offset aligned
+template <class T, int Padding = (4 - sizeof(T) % 4) % 4>
+struct AttributeSlot
+{
+	T value;
+	unsigned char padding[Padding];
+};
+
+template <class T>
+struct AttributeSlot<T, 0>
+{
+	T value;
+};
+
+// an interleaved vertex made of the attributes in order, attribute<I>()
+// gets at them
+template <class... Attributes> struct PackedVertex;
+
+template <class Last>
+struct PackedVertex<Last>
+{
+	AttributeSlot<Last> head;
+};
+
+template <class First, class... Rest>
+struct PackedVertex<First, Rest...>
+{
+	AttributeSlot<First> head;
+	PackedVertex<Rest...> tail;
+};
+
+template <int I, class Vertex> struct VertexElement;
+
+template <class First, class... Rest>
+struct VertexElement<0, PackedVertex<First, Rest...> >
+{
+	typedef First Type;
+	static Type &get(PackedVertex<First, Rest...> &vertex) { return vertex.head.value; }
+};
+
+template <int I, class First, class... Rest>
+struct VertexElement<I, PackedVertex<First, Rest...> >
+{
+	typedef VertexElement<I - 1, PackedVertex<Rest...> > Next;
+	typedef typename Next::Type Type;
+	static Type &get(PackedVertex<First, Rest...> &vertex) { return Next::get(vertex.tail); }
+};
+
+template <int I, class... Attributes>
+typename VertexElement<I, PackedVertex<Attributes...> >::Type &attribute(PackedVertex<Attributes...> &vertex)
+{
+	return VertexElement<I, PackedVertex<Attributes...> >::get(vertex);
+}
+
+// the glVertexAttribPointer calls for attributes at Location and up, every
+// argument is a compile time constant
+template <GLuint Location, size_t Offset, class... Attributes> struct AttributeList;
+
+template <GLuint Location, size_t Offset>
+struct AttributeList<Location, Offset>
+{
+	enum { size = 0 };
+	static void setup(GLsizei) {}
+};
+
+template <GLuint Location, size_t Offset, class First, class... Rest>
+struct AttributeList<Location, Offset, First, Rest...>
+{
+	typedef typename First::Component Component;
+	typedef AttributeList<Location + 1, Offset + sizeof(AttributeSlot<First>), Rest...> Next;
+
+	enum { size = sizeof(AttributeSlot<First>) + Next::size };
+
+	static void setup(GLsizei stride)
+	{
+		glEnableVertexAttribArray(Location);
+		glVertexAttribPointer(Location, First::components, GLComponent<Component>::type,
+			GLComponent<Component>::normalized, stride, (const GLvoid *)Offset);
+		Next::setup(stride);
+	}
+};
+
+// packed interleaved vertex format, attribute i goes to location i. e.g.
+//
+//	typedef VertexLayout<Vec3h, Vec2<unsigned short> > Layout;
+//	Layout::Vertex vertex;
+//	attribute<0>(vertex) = Vec3h(x, y, z);
+//	...
+//	Layout::setup(); // with the vertex array and buffer bound
+template <class... Attributes>
+struct VertexLayout
+{
+	typedef PackedVertex<Attributes...> Vertex;
+	typedef AttributeList<0, 0, Attributes...> List;
+
+	enum
+	{
+		count = sizeof...(Attributes),
+		stride = List::size
+	};
+
+	static_assert(sizeof(Vertex) == stride, "vertex layout has compiler padding");
+
+	static void setup()
+	{
+		List::setup(stride);
+	}
+};
+
+// narrowest index type that can address vertexCount vertices. 8 bit indices
+// are left out, several gpus convert them on the cpu
+inline GLenum indexTypeFor(size_t vertexCount)
+{
+	return vertexCount <= 0x10000 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+}
+
+inline size_t indexSize(GLenum type)
+{
+	return type == GL_UNSIGNED_BYTE ? 1 : (type == GL_UNSIGNED_SHORT ? 2 : 4);
+}
+
+#endif
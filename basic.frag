@@ -1,138 +1,89 @@
 #version 330
 
 in vec2 v_uv;
-out vec4 FragColor;
+layout(location = 0) out vec4 FragColor;
 
-uniform float u_Time;
-uniform vec2 u_Resolution;
+#ifdef GBUFFER
+layout(location = 1) out vec4 NormalDepth; // xyz normal, w ray length or -1 on a miss
+#endif
 
-// Distance functions by Iigo Qulez 
-// http://iquilezles.org/www/articles/distfunctions/distfunctions.htm
-
-// utility
-mat4 makeRotation(float rads, float x, float y, float z)
-{
-    vec3 v = normalize(vec3(x, y, z));
-    float c = cos(rads);
-    float cp = 1. - c;
-    float s = sin(rads);
-    
-    return mat4(c + cp * v.x * v.x,
-                cp * v.x * v.y - v.z * s,
-                cp * v.x * v.z + v.y * s,
-                0.,
-                
-                cp * v.x * v.y + v.z * s,
-                c + cp * v.y * v.y,
-                cp * v.y * v.z - v.x * s,
-                0.,
-                
-                cp * v.x * v.z - v.y * s,
-                cp * v.y * v.z + v.x * s,
-                c + cp * v.z * v.z,
-                0.,
-                
-                0.0, 0.0, 0.0, 1.0);
-}
+#ifdef PROGRESSIVE
+layout(location = 1) out vec4 Moments;	// luminance and its square, for the noise estimate
+uniform vec2 u_Jitter;					// sample offset in pixels
+#endif
 
+#ifdef BACKGROUND_TEXTURE
+uniform sampler2D u_Background;	// streamed in by TextureStreamer, --texture
+#endif
 
-// scene
-#define MAX_STEPS 128
-#define MAX_DEPTH 8.0
+#include "scene.glsl"
 
-float sdBox( vec3 p, vec3 b )
-{
-	p = (makeRotation(u_Time, 1.0, 1.0, 1.0) * vec4(p, 1.0)).xyz;
-	vec3 d = abs(p) - b;
-	return min(max(d.x, max(d.y, d.z)), 0.0) + length(max(d, 0.0));
-}
+#ifndef AA_SAMPLES
+#define AA_SAMPLES 1
+#endif
 
-float repeatBox( vec3 p, vec3 c )
+// radical inverse, gives a low discrepancy pattern for the jittered samples
+float halton(int i, int base)
 {
-    vec3 q = -0.5 * c + mod(p,c);
-    return sdBox(q, vec3(0.015 * (sin(u_Time) + 1.5)));
+	float f = 1.0;
+	float r = 0.0;
+	
+	while (i > 0)
+	{
+		f /= float(base);
+		r += f * float(i % base);
+		i /= base;
+	}
+	
+	return r;
 }
 
-vec2 scene(in vec3 p)
+// the scene with misses and far hits fading into the background texture
+vec3 shade(in vec2 uv, out vec4 normalDepth)
 {
-	return vec2(repeatBox(p, vec3(0.15)), 1.0);
+	vec3 color = render(uv, 0.0, normalDepth);
+#ifdef BACKGROUND_TEXTURE
+	float far = normalDepth.w < 0.0 ? 1.0 : smoothstep(0.25, 1.0, normalDepth.w / MAX_DEPTH);
+	color = mix(color, texture(u_Background, uv).rgb, far);
+#endif
+	return color;
 }
 
-vec3 calcNormal(in vec3 p)
+// sample 0 is the pixel centre, the rest follow a halton pattern
+vec2 sampleOffset(int i)
 {
-	vec3 e = vec3(0.001, 0.0, 0.0);
-	
-	vec3 n;
-	
-	n.x = scene(p + e.xyy).x - scene(p - e.xyy).x;
-	n.y = scene(p + e.yxy).x - scene(p - e.yxy).x;
-	n.z = scene(p + e.yyx).x - scene(p - e.yyx).x;
-	
-	return normalize(n);
-}
-
-vec2 intersect(in vec3 origin, in vec3 direction)
-{
-	float rayLength = 0.0;
-    vec2 hit;
-	for (int i = 0; i < MAX_STEPS; ++i)
-	{
-		if (rayLength > MAX_DEPTH)
-			break;
-		
-		hit = scene(direction * rayLength + origin);
-		if (hit.x < 0.001)
-			break;
-		
-		// partially increment to reduce artifacts
-		rayLength += 0.75 * hit.x;
-	}
-	
-	return vec2(rayLength, hit.y);
+	return i == 0 ? vec2(0.0) : vec2(halton(i, 2), halton(i, 3)) - 0.5;
 }
 
 void main()
 {
-	//setup space
-	vec2 uv = v_uv;
-	vec2 p = uv * 2.0 - 1.0; 
-	p.x *= u_Resolution.x / u_Resolution.y;
+	vec4 normalDepth;
 	
-	//setup camera
-	vec3 camPosition = vec3(0.0, 0.0, 2.0);
-	vec3 camUp = vec3(0.0, 1.0, 0.0);
-	vec3 camDirection = vec3(0.0, 0.0, -1.0);
-	vec3 camRight = cross(camDirection, camUp);
-	vec3 rayDirection = normalize(p.x * camRight + 
-								  p.y * camUp + 
-								  1.5 * camDirection);
+#if defined(PROGRESSIVE)
+	// one sample per pass, ProgressiveRenderer accumulates them with blending
+	vec3 color = shade(v_uv + u_Jitter / u_Resolution, normalDepth);
+	float luminance = dot(color, vec3(0.299, 0.587, 0.114));
+	
+	FragColor = vec4(color, 1.0);
+	Moments = vec4(luminance, luminance * luminance, 0.0, 0.0);
+#elif AA_SAMPLES > 1
+#ifdef REFINE
+	// the centre sample is already in the target and gets blended in (see AdaptiveAA)
+	const int firstSample = 1;
+#else
+	const int firstSample = 0;
+#endif
 	
 	vec3 color = vec3(0.0);
-	vec2 result = intersect(camPosition, rayDirection);
+	for (int i = firstSample; i < AA_SAMPLES; ++i)
+		color += shade(v_uv + sampleOffset(i) / u_Resolution, normalDepth);
 	
-	if (result.y > 0.5) // if we have a material
-	{
-		float constantAttenuation = 2.0;
-		float linearAttenuation = 1.0;
-		float quadraticAttenuation = 0.5;
-		float dist = result.x;
-		
-		float att = 1.0 / (constantAttenuation + dist * (linearAttenuation  + quadraticAttenuation * dist));
-			
-		vec3 position = camPosition + rayDirection * result.x;
-		vec3 normal = calcNormal(position);
-		vec3 light = normalize(position + vec3(0., 0.8, -1. * (sin(u_Time) + 1.)));
-		vec3 blight = vec3(-light.x, light.y, -light.z);
-		vec3 R = reflect(rayDirection, normal);
-		float specular = 0.5 * pow(clamp(dot(light, R), 0.0, 1.0), 8.0);
-		
-		if (result.y == 1.0)
-		{
-			color += vec3(0.75) * att;
-			color += max(0., dot(normal, light)) * vec3(1.) * att;
-			color += specular * att;
-		}
-	}
+	FragColor = vec4(color, float(AA_SAMPLES - firstSample)) / float(AA_SAMPLES);
+#else
+	FragColor = vec4(shade(v_uv, normalDepth), 1.0);
+#endif
 
-	FragColor = vec4(color, 1.0);
+#ifdef GBUFFER
+	NormalDepth = normalDepth;
+#endif
 }
\ No newline at end of file
@@ -0,0 +1,40 @@
+#version 330
+
+in vec2 v_uv;
+out vec4 FragColor;
+
+uniform sampler2D u_NormalDepth;
+
+// marks pixels whose neighbourhood has a depth or normal discontinuity, the
+// rest are discarded so only edges end up in the stencil buffer
+#define DEPTH_THRESHOLD 0.05	// relative ray length difference
+#define NORMAL_THRESHOLD 0.9	// cosine of the angle between normals
+
+bool isEdge(vec4 a, vec4 b)
+{
+	// a hit next to a miss
+	if ((a.w < 0.0) != (b.w < 0.0))
+		return true;
+	
+	if (a.w < 0.0)
+		return false;
+	
+	return abs(a.w - b.w) > DEPTH_THRESHOLD * min(a.w, b.w) ||
+		   dot(a.xyz, b.xyz) < NORMAL_THRESHOLD;
+}
+
+void main()
+{
+	ivec2 p = ivec2(gl_FragCoord.xy);
+	ivec2 last = textureSize(u_NormalDepth, 0) - 1;
+	
+	vec4 center = texelFetch(u_NormalDepth, p, 0);
+	
+	if (!(isEdge(center, texelFetch(u_NormalDepth, clamp(p + ivec2(1, 0), ivec2(0), last), 0)) ||
+		  isEdge(center, texelFetch(u_NormalDepth, clamp(p - ivec2(1, 0), ivec2(0), last), 0)) ||
+		  isEdge(center, texelFetch(u_NormalDepth, clamp(p + ivec2(0, 1), ivec2(0), last), 0)) ||
+		  isEdge(center, texelFetch(u_NormalDepth, clamp(p - ivec2(0, 1), ivec2(0), last), 0))))
+		discard;
+	
+	FragColor = vec4(1.0);
+}
\ No newline at end of file
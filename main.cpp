@@ -2,6 +2,7 @@
 #include <chrono>
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
+#include "JobSystem.h"
 #include "Mat4.h"
 #include "Shader.h"
 #include <stdio.h>
@@ -10,8 +11,10 @@
 
 int main(int argc, char *argv[])
 {
-	if (Application::getInstance().initialize(argc, argv))
-		Application::getInstance().run();
+	const bool success = Application::getInstance().initialize(argc, argv) && Application::getInstance().run();
 
-	return 0;
+	// join the workers before static destruction
+	JobSystem::getInstance().shutdown();
+
+	return success ? 0 : 1;
 }
\ No newline at end of file
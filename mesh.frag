@@ -0,0 +1,11 @@
+#version 330
+
+in vec3 v_Normal;
+in vec2 v_uv;
+
+out vec4 FragColor;
+
+void main()
+{
+	FragColor = vec4((normalize(v_Normal) * 0.5 + 0.5) * fract(v_uv.x * 8.0), 1.0);
+}
\ No newline at end of file
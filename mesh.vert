@@ -0,0 +1,18 @@
+#version 330
+
+layout (location = 0) in vec3 a_Position;
+layout (location = 1) in vec3 a_Normal;
+layout (location = 2) in vec2 a_TexCoord;
+
+uniform mat4 u_ModelViewProjectionMatrix;
+
+out vec3 v_Normal;
+out vec2 v_uv;
+
+// generic mesh for --bench-vertex, reads every attribute so none gets optimized out
+void main()
+{
+	v_Normal = a_Normal;
+	v_uv = a_TexCoord;
+	gl_Position = u_ModelViewProjectionMatrix * vec4(a_Position, 1.0);
+}
\ No newline at end of file
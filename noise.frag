@@ -0,0 +1,27 @@
+#version 330
+
+in vec2 v_uv;
+out vec4 FragColor;
+
+uniform sampler2D u_Accumulation;	// colour sum, sample count in alpha
+uniform sampler2D u_Moments;		// luminance sum and sum of squares
+
+// standard error of the mean luminance of each pixel, ProgressiveRenderer
+// mipmaps this down to one value to decide when a still has converged
+void main()
+{
+	ivec2 p = ivec2(gl_FragCoord.xy);
+	float n = texelFetch(u_Accumulation, p, 0).a;
+	vec2 m = texelFetch(u_Moments, p, 0).xy;
+	
+	if (n < 2.0)
+	{
+		FragColor = vec4(1.0);
+		return;
+	}
+	
+	float mean = m.x / n;
+	float variance = max(m.y / n - mean * mean, 0.0) * n / (n - 1.0);
+	
+	FragColor = vec4(sqrt(variance / n));
+}
\ No newline at end of file
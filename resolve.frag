@@ -0,0 +1,12 @@
+#version 330
+
+in vec2 v_uv;
+out vec4 FragColor;
+
+uniform sampler2D u_Accumulation;	// colour sum, sample count in alpha
+
+void main()
+{
+	vec4 sum = texture(u_Accumulation, v_uv);
+	FragColor = vec4(sum.rgb / max(sum.a, 1.0), 1.0);
+}
\ No newline at end of file